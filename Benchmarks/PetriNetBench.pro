@@ -0,0 +1,14 @@
+QT       += core gui concurrent
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = PetriNetBench
+
+include(../Core/core.pri)
+include(../Scene/scene.pri)
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,473 @@
+// main.cpp
+// Бенчмарки движков, файлового ввода-вывода и сцены на синтетических сетях.
+// Результаты выводятся в JSON для отслеживания регрессий между сборками.
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDateTime>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <functional>
+
+#include "../Core/netgenerators.h"
+#include "../Core/netlayout.h"
+#include "../Core/petriprofiler.h"
+#include "../Core/petrisimulator.h"
+#include "../Core/queuesimulator.h"
+#include "../Core/statespace.h"
+#include "../Core/unfolding.h"
+#include "../Scene/petrinetscene.h"
+
+namespace {
+
+struct NetCase {
+    QString name;
+    QJsonObject params;
+    PetriNetModel model;
+};
+
+class BenchRunner
+{
+public:
+    BenchRunner(const QString& filter, bool quick)
+        : m_filter(filter),
+        m_quick(quick)
+    {
+    }
+
+    bool quick() const { return m_quick; }
+
+    // Запуск повторяется, пока суммарное время не превысит minSeconds;
+    // в результат идёт лучший из запусков
+    void run(const QString& name, const QJsonObject& params, const QString& metric,
+             const std::function<double()>& body)
+    {
+        if (!matches(name))
+            return;
+
+        const double minSeconds = m_quick ? 0.05 : 0.5;
+        double best = -1;
+        double bestSeconds = 0;
+        double total = 0;
+        int repeats = 0;
+        while (total < minSeconds || repeats < 3) {
+            QElapsedTimer timer;
+            timer.start();
+            const double work = body();
+            const double seconds = timer.nsecsElapsed() / 1e9;
+            total += seconds;
+            repeats++;
+
+            const double rate = seconds > 0 ? work / seconds : 0;
+            if (rate > best) {
+                best = rate;
+                bestSeconds = seconds;
+            }
+            if (repeats >= 1000)
+                break;
+        }
+
+        QJsonObject result;
+        result["name"] = name;
+        result["params"] = params;
+        result["repeats"] = repeats;
+        result["seconds"] = bestSeconds;
+        result["metric"] = metric;
+        result["value"] = best;
+        m_results.append(result);
+
+        QTextStream(stderr) << name << ' ' << QJsonDocument(params).toJson(QJsonDocument::Compact)
+                            << ": " << best << ' ' << metric << Qt::endl;
+    }
+
+    // Результат, измеренный самим бенчмарком
+    void record(const QString& name, const QJsonObject& params, const QString& metric, double value, double seconds)
+    {
+        if (!matches(name))
+            return;
+
+        QJsonObject result;
+        result["name"] = name;
+        result["params"] = params;
+        result["repeats"] = 1;
+        result["seconds"] = seconds;
+        result["metric"] = metric;
+        result["value"] = value;
+        m_results.append(result);
+
+        QTextStream(stderr) << name << ": " << value << ' ' << metric << Qt::endl;
+    }
+
+    bool matches(const QString& name) const
+    {
+        return m_filter.isEmpty() || name.contains(m_filter, Qt::CaseInsensitive);
+    }
+
+    QJsonObject report() const
+    {
+        QJsonObject report;
+        report["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+        report["qt"] = QString(qVersion());
+        report["cpu"] = QSysInfo::currentCpuArchitecture();
+        report["os"] = QSysInfo::prettyProductName();
+        report["quick"] = m_quick;
+        report["profiling"] = PetriProfiler::isCompiledIn();
+#ifdef QT_DEBUG
+        report["build"] = "debug";
+#else
+        report["build"] = "release";
+#endif
+        report["results"] = m_results;
+        return report;
+    }
+
+private:
+    QString m_filter;
+    bool m_quick;
+    QJsonArray m_results;
+};
+
+QVector<NetCase> netCases(bool quick)
+{
+    const int scale = quick ? 1 : 4;
+    QVector<NetCase> cases;
+    for (int n : {5, 10 * scale}) {
+        cases.append({"philosophers", QJsonObject{{"n", n}}, NetGenerators::diningPhilosophers(n)});
+    }
+    for (int stages : {10, 50 * scale}) {
+        cases.append({"pipeline", QJsonObject{{"stages", stages}, {"tokens", stages / 2}},
+                      NetGenerators::pipeline(stages, stages / 2)});
+    }
+    for (int size : {100, 1000 * scale}) {
+        cases.append({"random", QJsonObject{{"places", size}, {"transitions", size}, {"seed", 42}},
+                      NetGenerators::randomSparse(size, size, 42)});
+    }
+    for (int side : {4, 10 * scale}) {
+        cases.append({"grid", QJsonObject{{"width", side}, {"height", side}}, NetGenerators::grid(side, side)});
+    }
+    cases.append({"producerConsumer", QJsonObject{{"producers", 4}, {"consumers", 4}},
+                  NetGenerators::producerConsumer(4, 4)});
+    return cases;
+}
+
+// Пространство состояний растёт экспоненциально, поэтому здесь свои размеры
+QVector<NetCase> stateSpaceCases(bool quick)
+{
+    QVector<NetCase> cases;
+    const int philosophers = quick ? 6 : 9;
+    cases.append({"philosophers", QJsonObject{{"n", philosophers}},
+                  NetGenerators::diningPhilosophers(philosophers)});
+    const int stages = quick ? 8 : 14;
+    cases.append({"pipeline", QJsonObject{{"stages", stages}, {"tokens", stages / 2}},
+                  NetGenerators::pipeline(stages, stages / 2)});
+    const int side = quick ? 3 : 4;
+    cases.append({"grid", QJsonObject{{"width", side}, {"height", side}}, NetGenerators::grid(side, side)});
+    cases.append({"producerConsumer", QJsonObject{{"producers", 2}, {"consumers", 2}},
+                  NetGenerators::producerConsumer(2, 2)});
+    return cases;
+}
+
+QJsonObject withParam(QJsonObject params, const QString& key, const QJsonValue& value)
+{
+    params[key] = value;
+    return params;
+}
+
+void benchFiring(BenchRunner& runner)
+{
+    const qint64 steps = runner.quick() ? 100000 : 1000000;
+    for (const NetCase& net : netCases(runner.quick())) {
+        const CompiledNet compiled = CompiledNet::fromModel(net.model);
+        runner.run("firing/" + net.name, withParam(net.params, "steps", steps), "firings/s", [&]() {
+            PetriSimulator simulator(compiled, 1);
+            return double(simulator.run(steps));
+        });
+    }
+}
+
+// Неограниченный буфер-очередь: число живых фишек растёт до миллионов
+void benchQueues(BenchRunner& runner)
+{
+    const int producers = 8;
+    const int consumers = 2;
+    PetriNetModel model = NetGenerators::producerConsumer(producers, consumers);
+    for (PlaceData& place : model.places)
+        place.queue = place.label == "buffer";
+    const CompiledNet compiled = CompiledNet::fromModel(model);
+
+    const qint64 steps = runner.quick() ? 1000000 : 10000000;
+    qint64 liveTokens = 0;
+    qint64 memoryBytes = 0;
+    const QJsonObject params{{"producers", producers}, {"consumers", consumers}, {"steps", steps}};
+    runner.run("queue/producerConsumer", params, "firings/s", [&]() {
+        QueueSimulator simulator(compiled, 1);
+        const qint64 fired = simulator.run(steps);
+        liveTokens = simulator.liveTokens();
+        memoryBytes = simulator.memoryBytes();
+        return double(fired);
+    });
+    if (runner.matches("queue/producerConsumer")) {
+        runner.record("queue/producerConsumer/liveTokens", params, "tokens", double(liveTokens), 0);
+        runner.record("queue/producerConsumer/memory", params, "bytes/token",
+                      liveTokens > 0 ? double(memoryBytes) / liveTokens : 0, 0);
+    }
+}
+
+void benchStateSpace(BenchRunner& runner)
+{
+    const int maxStates = runner.quick() ? 100000 : 2000000;
+    for (const NetCase& net : stateSpaceCases(runner.quick())) {
+        const CompiledNet compiled = CompiledNet::fromModel(net.model);
+        runner.run("statespace/" + net.name, withParam(net.params, "maxStates", maxStates), "states/s", [&]() {
+            StateSpaceOptions options;
+            options.maxStates = maxStates;
+            StateStore store(compiled.placeCount());
+            return double(StateSpace::explore(compiled, options, &store).states);
+        });
+    }
+}
+
+// Префикс развёртки против явного перебора на одних и тех же сетях:
+// размер префикса растёт линейно там, где число состояний — экспоненциально
+void benchUnfolding(BenchRunner& runner)
+{
+    const int maxStates = runner.quick() ? 100000 : 2000000;
+    QVector<NetCase> cases;
+    for (int n : {runner.quick() ? 6 : 9, runner.quick() ? 20 : 50}) {
+        cases.append({"philosophers", QJsonObject{{"n", n}}, NetGenerators::diningPhilosophers(n)});
+    }
+    // Неразличимые фишки в одной позиции порождают симметричные события,
+    // поэтому конвейер берётся с двумя заявками
+    const int stages = runner.quick() ? 8 : 14;
+    cases.append({"pipeline", QJsonObject{{"stages", stages}, {"tokens", 2}}, NetGenerators::pipeline(stages, 2)});
+
+    for (const NetCase& net : cases) {
+        const QString name = "unfolding/" + net.name;
+        if (!runner.matches(name))
+            continue;
+        const CompiledNet compiled = CompiledNet::fromModel(net.model);
+
+        int events = 0;
+        runner.run(name, net.params, "events/s", [&]() {
+            const Unfolding unfolding = Unfolding::build(compiled);
+            events = unfolding.events().size();
+            return double(events);
+        });
+
+        StateSpaceOptions options;
+        options.maxStates = maxStates;
+        QElapsedTimer timer;
+        timer.start();
+        StateStore store(compiled.placeCount());
+        const StateSpaceResult explored = StateSpace::explore(compiled, options, &store);
+        const double seconds = timer.nsecsElapsed() / 1e9;
+
+        const QJsonObject params = withParam(withParam(net.params, "events", events), "complete", explored.complete);
+        runner.record(name + "/explicitStates", params, "states", explored.states, seconds);
+        runner.record(name + "/compression", params, "states/event",
+                      events > 0 ? double(explored.states) / events : 0, seconds);
+    }
+}
+
+// Раскладка большой сети целиком: цель — 100 тысяч узлов за секунды.
+// Один прогон с настройками по умолчанию, как из меню Layout
+void benchLayout(BenchRunner& runner)
+{
+    const int half = runner.quick() ? 5000 : 50000;
+    const PetriNetModel model = NetGenerators::randomSparse(half, half, 42);
+    const LayoutGraph graph = LayoutGraph::fromModel(model);
+    QVector<QPointF> initial;
+    initial.reserve(graph.nodeCount());
+    for (const PlaceData& place : model.places)
+        initial.append(place.pos);
+    for (const TransitionData& transition : model.transitions)
+        initial.append(transition.pos);
+
+    for (LayoutOptions::Algorithm algorithm : {LayoutOptions::ForceDirected, LayoutOptions::Layered}) {
+        const bool force = algorithm == LayoutOptions::ForceDirected;
+        const QString name = force ? "layout/forceDirected" : "layout/layered";
+        if (!runner.matches(name))
+            continue;
+
+        LayoutOptions options;
+        options.algorithm = algorithm;
+        QElapsedTimer timer;
+        timer.start();
+        const QVector<QPointF> positions = force ? NetLayout::forceDirected(graph, initial, options)
+                                                 : NetLayout::layered(graph, options);
+        const double seconds = timer.nsecsElapsed() / 1e9;
+        QJsonObject params{{"nodes", graph.nodeCount()}, {"arcs", graph.edges.size()}};
+        if (force)
+            params["iterations"] = options.iterations;
+        runner.record(name, params, "s", positions.size() == graph.nodeCount() ? seconds : -1, seconds);
+    }
+}
+
+void benchFiles(BenchRunner& runner)
+{
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        return;
+
+    for (const NetCase& net : netCases(runner.quick())) {
+        const QString fileName = dir.filePath(net.name + ".json");
+        if (!net.model.saveToFile(fileName))
+            continue;
+        const double megabytes = QFileInfo(fileName).size() / (1024.0 * 1024.0);
+        const QJsonObject params = withParam(net.params, "bytes", QFileInfo(fileName).size());
+
+        runner.run("save/" + net.name, params, "MB/s", [&]() {
+            net.model.saveToFile(fileName);
+            return megabytes;
+        });
+        runner.run("load/" + net.name, params, "MB/s", [&]() {
+            PetriNetModel model;
+            PetriNetModel::loadFromFile(fileName, &model);
+            return megabytes;
+        });
+    }
+}
+
+template <typename T>
+void benchPaint(BenchRunner& runner, const QString& name, const QJsonObject& params, const QList<T*>& items)
+{
+    if (items.isEmpty())
+        return;
+
+    QImage image(1024, 1024, QImage::Format_ARGB32_Premultiplied);
+    QStyleOptionGraphicsItem option;
+    runner.run("paint/" + name, withParam(params, "items", items.size()), "items/s", [&]() {
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        for (T* item : items) {
+            option.rect = item->boundingRect().toRect();
+            option.exposedRect = item->boundingRect();
+            painter.save();
+            painter.translate(item->pos().x() * 0.1, item->pos().y() * 0.1);
+            item->paint(&painter, &option, nullptr);
+            painter.restore();
+        }
+        return double(items.size());
+    });
+}
+
+void benchScene(BenchRunner& runner)
+{
+    for (const NetCase& net : netCases(runner.quick())) {
+        const int elements = net.model.places.size() + net.model.transitions.size() + net.model.arcs.size();
+        const QJsonObject params = withParam(net.params, "elements", elements);
+
+        PetriNetScene scene;
+        runner.run("scene/populate/" + net.name, params, "items/s", [&]() {
+            scene.loadModel(net.model);
+            return double(elements);
+        });
+
+        runner.run("scene/render/" + net.name, params, "frames/s", [&]() {
+            QImage image(1024, 1024, QImage::Format_ARGB32_Premultiplied);
+            QPainter painter(&image);
+            painter.setRenderHint(QPainter::Antialiasing);
+            scene.render(&painter, QRectF(image.rect()), scene.itemsBoundingRect());
+            return 1.0;
+        });
+
+        benchPaint(runner, "place/" + net.name, params, scene.places());
+        benchPaint(runner, "transition/" + net.name, params, scene.transitions());
+        benchPaint(runner, "arc/" + net.name, params, scene.arcs());
+    }
+}
+
+// Накладные расходы инструментирования: одна и та же смешанная нагрузка
+// с включёнными и выключенными замерами (имеет смысл в сборке CONFIG+=profiling)
+void benchProfilerOverhead(BenchRunner& runner)
+{
+    if (!PetriProfiler::isCompiledIn() || !runner.matches("profiler/overhead"))
+        return;
+
+    const CompiledNet firingNet = CompiledNet::fromModel(NetGenerators::randomSparse(1000, 1000, 42));
+    const CompiledNet exploreNet = CompiledNet::fromModel(NetGenerators::diningPhilosophers(runner.quick() ? 6 : 8));
+    PetriNetScene scene;
+    scene.loadModel(NetGenerators::grid(20, 20));
+    QImage image(1024, 1024, QImage::Format_ARGB32_Premultiplied);
+
+    auto workload = [&]() {
+        QElapsedTimer timer;
+        timer.start();
+        // Короткие пакеты срабатываний — худший случай для замеров run()
+        PetriSimulator simulator(firingNet, 1);
+        for (int batch = 0; batch < 200; ++batch)
+            simulator.run(1000);
+        StateSpaceOptions options;
+        StateStore store(exploreNet.placeCount());
+        StateSpace::explore(exploreNet, options, &store);
+        QPainter painter(&image);
+        scene.render(&painter, QRectF(image.rect()), scene.itemsBoundingRect());
+        return timer.nsecsElapsed() / 1e9;
+    };
+
+    const bool wasEnabled = PetriProfiler::isEnabled();
+    double enabled = 1e30;
+    double disabled = 1e30;
+    const int rounds = runner.quick() ? 3 : 7;
+    workload(); // Прогрев
+    for (int round = 0; round < rounds; ++round) {
+        PetriProfiler::setEnabled(false);
+        disabled = qMin(disabled, workload());
+        PetriProfiler::setEnabled(true);
+        enabled = qMin(enabled, workload());
+    }
+    PetriProfiler::setEnabled(wasEnabled);
+
+    runner.record("profiler/overhead", QJsonObject{{"rounds", rounds}, {"enabledSeconds", enabled},
+                                                   {"disabledSeconds", disabled}},
+                  "%", 100.0 * (enabled - disabled) / disabled, enabled);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+    QApplication::setApplicationName("PetriNetBench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Petri net editor benchmarks");
+    parser.addHelpOption();
+    QCommandLineOption filterOption({"f", "filter"}, "Run only benchmarks whose name contains <text>.", "text");
+    QCommandLineOption outputOption({"o", "output"}, "Write JSON results to <file> instead of stdout.", "file");
+    QCommandLineOption quickOption("quick", "Use small nets and short runs.");
+    parser.addOptions({filterOption, outputOption, quickOption});
+    parser.process(a);
+
+    BenchRunner runner(parser.value(filterOption), parser.isSet(quickOption));
+    benchFiring(runner);
+    benchQueues(runner);
+    benchStateSpace(runner);
+    benchUnfolding(runner);
+    benchLayout(runner);
+    benchFiles(runner);
+    benchScene(runner);
+    benchProfilerOverhead(runner);
+
+    const QByteArray json = QJsonDocument(runner.report()).toJson();
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly)) {
+            QTextStream(stderr) << "Cannot write " << file.fileName() << ": " << file.errorString() << Qt::endl;
+            return 1;
+        }
+        file.write(json);
+    } else {
+        QTextStream(stdout) << json;
+    }
+    return 0;
+}
@@ -0,0 +1,12 @@
+QT       += core concurrent
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = PetriNetCli
+
+include(../Core/core.pri)
+
+SOURCES += \
+    main.cpp
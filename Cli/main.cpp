@@ -0,0 +1,748 @@
+// main.cpp
+// Пакетный анализ и моделирование сетей без графического интерфейса.
+// Использует те же движки из Core, что и редактор.
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "../Core/invariants.h"
+#include "../Core/petrisimulator.h"
+#include "../Core/queuesimulator.h"
+#include "../Core/statespace.h"
+#include "../Core/unfolding.h"
+
+namespace {
+
+enum class Command {
+    Simulate,
+    Ensemble,
+    Reachability,
+    Invariants,
+    Unfold
+};
+
+struct Settings {
+    Command command{Command::Simulate};
+    int threads{1};
+    qint64 timeoutMs{0};
+    qint64 steps{100000};
+    double maxTime{0};       // Модельное время для сетей с очередями
+    int runs{100};
+    quint32 seed{1};
+    int maxStates{1000000};
+    int maxEvents{200000};
+    QVector<QPair<QString, int>> marking;   // Цель проверки достижимости для unfold
+    bool cover{false};                      // Покрытие вместо точного совпадения
+    qint64 maxMemoryBytes{0};
+    int maxRows{20000};
+    bool parallelRuns{true}; // Прогоны ансамбля параллельно (если модели идут по одной)
+};
+
+const char* commandName(Command command)
+{
+    switch (command) {
+    case Command::Simulate: return "simulate";
+    case Command::Ensemble: return "ensemble";
+    case Command::Reachability: return "reachability";
+    case Command::Invariants: return "invariants";
+    case Command::Unfold: return "unfold";
+    }
+    return "";
+}
+
+const char* limitName(StateSpaceResult::Limit limit)
+{
+    switch (limit) {
+    case StateSpaceResult::NoLimit: return "none";
+    case StateSpaceResult::StateLimit: return "states";
+    case StateSpaceResult::MemoryLimit: return "memory";
+    case StateSpaceResult::TimeLimit: return "timeout";
+    case StateSpaceResult::Cancelled: return "cancelled";
+    }
+    return "";
+}
+
+// Выставляет флаг отмены по истечении времени для движков без своих часов
+class Watchdog
+{
+public:
+    explicit Watchdog(qint64 timeoutMs)
+    {
+        if (timeoutMs <= 0)
+            return;
+        m_thread = std::thread([this, timeoutMs]() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!m_wake.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this]() { return m_done; }))
+                m_cancel.store(true);
+        });
+    }
+
+    ~Watchdog()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done = true;
+        }
+        m_wake.notify_all();
+        if (m_thread.joinable())
+            m_thread.join();
+    }
+
+    const std::atomic<bool>* flag() const { return &m_cancel; }
+    bool fired() const { return m_cancel.load(); }
+
+private:
+    std::atomic<bool> m_cancel{false};
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_done{false};
+    std::thread m_thread;
+};
+
+struct RunResult {
+    qint64 steps{0};
+    bool deadlocked{false};
+    bool timedOut{false};
+    QVector<int> marking;
+    QVector<qint64> firingCounts;
+};
+
+RunResult runOnce(const CompiledNet& net, const Settings& settings, quint32 seed)
+{
+    // Прогон идёт порциями, чтобы проверять время
+    const qint64 chunk = 65536;
+    QElapsedTimer timer;
+    timer.start();
+
+    RunResult result;
+    PetriSimulator simulator(net, seed);
+    while (result.steps < settings.steps) {
+        const qint64 wanted = qMin(chunk, settings.steps - result.steps);
+        const qint64 fired = simulator.run(wanted);
+        result.steps += fired;
+        if (fired < wanted)
+            break;
+        if (settings.timeoutMs > 0 && timer.elapsed() > settings.timeoutMs) {
+            result.timedOut = true;
+            break;
+        }
+    }
+    result.deadlocked = simulator.isDeadlocked();
+    result.marking = simulator.marking();
+    result.firingCounts = simulator.firingCounts();
+    return result;
+}
+
+template <typename T>
+QJsonObject byLabel(const QStringList& labels, const QVector<T>& values)
+{
+    QJsonObject json;
+    for (int i = 0; i < labels.size(); ++i)
+        json[labels[i]] = double(values[i]);
+    return json;
+}
+
+// Сеть с позициями-очередями моделируется во времени со статистикой очередей
+QJsonObject simulateQueues(const CompiledNet& net, const Settings& settings)
+{
+    const qint64 chunk = 65536;
+    QElapsedTimer timer;
+    timer.start();
+
+    QueueSimulator simulator(net, settings.seed);
+    qint64 steps = 0;
+    bool timedOut = false;
+    while (steps < settings.steps) {
+        const qint64 wanted = qMin(chunk, settings.steps - steps);
+        const qint64 fired = simulator.run(wanted, settings.maxTime);
+        steps += fired;
+        if (fired < wanted)
+            break;
+        if (settings.timeoutMs > 0 && timer.elapsed() > settings.timeoutMs) {
+            timedOut = true;
+            break;
+        }
+    }
+    const double seconds = timer.nsecsElapsed() / 1e9;
+
+    QJsonObject queues;
+    for (int place : simulator.queuePlaces()) {
+        const QueueStats stats = simulator.stats(place);
+        queues[net.placeLabels[place]] = QJsonObject{
+            {"arrivals", double(stats.arrivals)},
+            {"departures", double(stats.departures)},
+            {"meanWait", stats.meanWait()},
+            {"maxWait", stats.maxWait},
+            {"meanLength", stats.meanLength(simulator.time())},
+            {"maxLength", double(stats.maxLength)},
+            {"length", double(stats.length)}
+        };
+    }
+
+    QJsonObject json;
+    json["seed"] = double(settings.seed);
+    json["steps"] = double(steps);
+    json["time"] = simulator.time();
+    json["deadlocked"] = simulator.isDeadlocked();
+    json["timedOut"] = timedOut;
+    json["firingsPerSecond"] = seconds > 0 ? steps / seconds : 0.0;
+    json["liveTokens"] = double(simulator.liveTokens());
+    json["tokenMemoryBytes"] = double(simulator.memoryBytes());
+    json["marking"] = byLabel(net.placeLabels, simulator.marking());
+    json["firingCounts"] = byLabel(net.transitionLabels, simulator.firingCounts());
+    json["queues"] = queues;
+    return json;
+}
+
+QJsonObject simulate(const CompiledNet& net, const Settings& settings)
+{
+    if (net.hasQueues())
+        return simulateQueues(net, settings);
+
+    QElapsedTimer timer;
+    timer.start();
+    const RunResult run = runOnce(net, settings, settings.seed);
+    const double seconds = timer.nsecsElapsed() / 1e9;
+
+    QJsonObject json;
+    json["seed"] = double(settings.seed);
+    json["steps"] = double(run.steps);
+    json["deadlocked"] = run.deadlocked;
+    json["timedOut"] = run.timedOut;
+    json["firingsPerSecond"] = seconds > 0 ? run.steps / seconds : 0.0;
+    json["marking"] = byLabel(net.placeLabels, run.marking);
+    json["firingCounts"] = byLabel(net.transitionLabels, run.firingCounts);
+    return json;
+}
+
+QJsonObject ensemble(const CompiledNet& net, const Settings& settings)
+{
+    QVector<quint32> seeds;
+    for (int i = 0; i < settings.runs; ++i)
+        seeds.append(settings.seed + quint32(i));
+
+    std::function<RunResult(quint32)> run = [&](quint32 seed) { return runOnce(net, settings, seed); };
+    QVector<RunResult> runs;
+    if (settings.parallelRuns) {
+        runs = QtConcurrent::blockingMapped<QVector<RunResult>>(seeds, run);
+    } else {
+        for (quint32 seed : seeds)
+            runs.append(run(seed));
+    }
+
+    // Среднее и стандартное отклонение конечной маркировки по прогонам
+    const int places = net.placeCount();
+    QVector<double> sum(places, 0);
+    QVector<double> sumSquares(places, 0);
+    QVector<double> firings(net.transitionCount(), 0);
+    double steps = 0;
+    int deadlocks = 0;
+    int timeouts = 0;
+    for (const RunResult& result : runs) {
+        for (int p = 0; p < places; ++p) {
+            sum[p] += result.marking[p];
+            sumSquares[p] += double(result.marking[p]) * result.marking[p];
+        }
+        for (int t = 0; t < firings.size(); ++t)
+            firings[t] += result.firingCounts[t];
+        steps += result.steps;
+        deadlocks += result.deadlocked ? 1 : 0;
+        timeouts += result.timedOut ? 1 : 0;
+    }
+
+    const double count = qMax(1, int(runs.size()));
+    QJsonObject tokens;
+    for (int p = 0; p < places; ++p) {
+        const double mean = sum[p] / count;
+        const double variance = qMax(0.0, sumSquares[p] / count - mean * mean);
+        tokens[net.placeLabels[p]] = QJsonObject{{"mean", mean}, {"stddev", std::sqrt(variance)}};
+    }
+    QJsonObject meanFirings;
+    for (int t = 0; t < firings.size(); ++t)
+        meanFirings[net.transitionLabels[t]] = firings[t] / count;
+
+    QJsonObject json;
+    json["runs"] = runs.size();
+    json["seed"] = double(settings.seed);
+    json["meanSteps"] = steps / count;
+    json["deadlockFraction"] = deadlocks / count;
+    json["timedOutRuns"] = timeouts;
+    json["tokens"] = tokens;
+    json["meanFirings"] = meanFirings;
+    return json;
+}
+
+QJsonObject reachability(const CompiledNet& net, const Settings& settings)
+{
+    StateSpaceOptions options;
+    options.maxStates = settings.maxStates;
+    options.maxMemoryBytes = settings.maxMemoryBytes;
+    options.timeoutMs = settings.timeoutMs;
+
+    QElapsedTimer timer;
+    timer.start();
+    StateStore store(net.placeCount());
+    const StateSpaceResult result = StateSpace::explore(net, options, &store);
+    const double seconds = timer.nsecsElapsed() / 1e9;
+
+    // Несколько тупиковых маркировок для диагностики
+    QJsonArray deadlocks;
+    for (int i = 0; i < qMin(10, int(result.deadlocks.size())); ++i) {
+        const int* state = store.state(result.deadlocks[i]);
+        deadlocks.append(byLabel(net.placeLabels, QVector<int>(state, state + net.placeCount())));
+    }
+
+    int maxBound = 0;
+    for (int bound : result.placeBounds)
+        maxBound = qMax(maxBound, bound);
+
+    QJsonObject json;
+    json["states"] = result.states;
+    json["edges"] = double(result.edges);
+    json["complete"] = result.complete;
+    json["stoppedBy"] = limitName(result.stoppedBy);
+    json["deadlocks"] = result.deadlocks.size();
+    json["maxBound"] = maxBound;
+    json["memoryBytes"] = double(store.memoryBytes());
+    json["statesPerSecond"] = seconds > 0 ? result.states / seconds : 0.0;
+    json["placeBounds"] = byLabel(net.placeLabels, result.placeBounds);
+    json["deadlockMarkings"] = deadlocks;
+    return json;
+}
+
+QJsonObject invariantsJson(const InvariantResult& result, const QStringList& labels)
+{
+    QJsonArray list;
+    for (const QVector<qint64>& invariant : result.invariants) {
+        QJsonObject weights;
+        for (int i = 0; i < invariant.size(); ++i) {
+            if (invariant[i] != 0)
+                weights[labels[i]] = double(invariant[i]);
+        }
+        list.append(weights);
+    }
+    QJsonArray uncovered;
+    for (int i = 0; i < result.covered.size(); ++i) {
+        if (!result.covered[i])
+            uncovered.append(labels[i]);
+    }
+
+    QJsonObject json;
+    json["count"] = result.invariants.size();
+    json["complete"] = result.complete;
+    json["invariants"] = list;
+    json["uncovered"] = uncovered;
+    return json;
+}
+
+QJsonObject invariants(const CompiledNet& net, const Settings& settings)
+{
+    Watchdog watchdog(settings.timeoutMs);
+    const InvariantResult place = Invariants::placeInvariants(net, settings.maxRows, watchdog.flag());
+    const InvariantResult transition = Invariants::transitionInvariants(net, settings.maxRows, watchdog.flag());
+
+    const QJsonObject placeJson = invariantsJson(place, net.placeLabels);
+    const QJsonObject transitionJson = invariantsJson(transition, net.transitionLabels);
+
+    QJsonObject json;
+    json["pInvariants"] = place.invariants.size();
+    json["tInvariants"] = transition.invariants.size();
+    json["complete"] = place.complete && transition.complete;
+    json["timedOut"] = watchdog.fired();
+    // Сеть, покрытая P-инвариантами, ограничена
+    json["coveredByPInvariants"] = placeJson["uncovered"].toArray().isEmpty() && place.complete;
+    json["place"] = placeJson;
+    json["transition"] = transitionJson;
+    return json;
+}
+
+const char* verdictName(Unfolding::Verdict verdict)
+{
+    switch (verdict) {
+    case Unfolding::No: return "no";
+    case Unfolding::Yes: return "yes";
+    case Unfolding::Unknown: return "unknown";
+    }
+    return "";
+}
+
+// Маркировка вида "p1=1,p2=0"; не названные позиции пусты
+bool parseMarking(const QString& text, QVector<QPair<QString, int>>* marking)
+{
+    for (const QString& part : text.split(',', Qt::SkipEmptyParts)) {
+        const int equals = part.lastIndexOf('=');
+        bool ok = false;
+        const int tokens = equals > 0 ? part.mid(equals + 1).trimmed().toInt(&ok) : -1;
+        if (!ok || tokens < 0)
+            return false;
+        marking->append({part.left(equals).trimmed(), tokens});
+    }
+    return true;
+}
+
+// Префикс развёртки и, для сравнения, явный перебор той же сети.
+// Построение, поиски по префиксу и явный перебор делят один срок --timeout
+QJsonObject unfold(const CompiledNet& net, const Settings& settings)
+{
+    // Метки цели проверяются до построения: ошибка не должна стоить времени
+    QVector<int> target;
+    if (!settings.marking.isEmpty()) {
+        target.fill(0, net.placeCount());
+        for (const QPair<QString, int>& entry : settings.marking) {
+            const int place = net.placeLabels.indexOf(entry.first);
+            if (place < 0)
+                return QJsonObject{{"ok", false}, {"error", "Unknown place in --marking: " + entry.first}};
+            target[place] = entry.second;
+        }
+    }
+
+    Watchdog watchdog(settings.timeoutMs);
+    UnfoldingOptions options;
+    options.maxEvents = settings.maxEvents;
+    options.cancel = watchdog.flag();
+
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    const Unfolding unfolding = Unfolding::build(net, options, &error);
+    if (!error.isEmpty())
+        return QJsonObject{{"ok", false}, {"supported", false}, {"error", error}};
+    const double buildSeconds = timer.nsecsElapsed() / 1e9;
+
+    // Причина ответа Unknown: срок, неполный префикс или бюджет шагов
+    auto searchStop = [&](Unfolding::Verdict verdict) {
+        if (verdict != Unfolding::Unknown) return "none";
+        if (watchdog.fired()) return "timeout";
+        if (!unfolding.isComplete()) return "prefix";
+        return "budget";
+    };
+
+    timer.restart();
+    QVector<int> dead;
+    const Unfolding::Verdict deadlock = unfolding.findDeadlock(&dead, 10000000, watchdog.flag());
+    const double deadlockSeconds = timer.nsecsElapsed() / 1e9;
+
+    timer.restart();
+    const Unfolding::Verdict reached = target.isEmpty()
+        ? Unfolding::Unknown : unfolding.findMarking(target, !settings.cover, 10000000, watchdog.flag());
+    const double markingSeconds = timer.nsecsElapsed() / 1e9;
+
+    StateSpaceOptions explicitOptions;
+    explicitOptions.maxStates = settings.maxStates;
+    explicitOptions.maxMemoryBytes = settings.maxMemoryBytes;
+    explicitOptions.cancel = watchdog.flag();     // Тот же срок, что у префикса
+    timer.restart();
+    StateStore store(net.placeCount());
+    const StateSpaceResult explored = StateSpace::explore(net, explicitOptions, &store);
+    const double exploreSeconds = timer.nsecsElapsed() / 1e9;
+
+    QJsonObject json;
+    json["supported"] = true;
+    json["events"] = unfolding.events().size();
+    json["conditions"] = unfolding.conditions().size();
+    json["cutoffs"] = unfolding.cutoffCount();
+    json["complete"] = unfolding.isComplete();
+    if (unfolding.isComplete())
+        json["stoppedBy"] = "none";
+    else if (watchdog.fired() && unfolding.stopReason() == "cancelled")
+        json["stoppedBy"] = "timeout";
+    else
+        json["stoppedBy"] = unfolding.stopReason();
+    json["unfoldSeconds"] = buildSeconds;
+    json["deadlock"] = verdictName(deadlock);
+    json["deadlockStoppedBy"] = searchStop(deadlock);
+    json["deadlockSeconds"] = deadlockSeconds;
+    if (deadlock == Unfolding::Yes)
+        json["deadlockMarking"] = byLabel(net.placeLabels, dead);
+    if (!target.isEmpty()) {
+        json["markingQuery"] = settings.cover ? "coverable" : "reachable";
+        json["marking"] = verdictName(reached);
+        json["markingStoppedBy"] = searchStop(reached);
+        json["markingSeconds"] = markingSeconds;
+    }
+    json["explicitStates"] = explored.states;
+    json["explicitComplete"] = explored.complete;
+    const bool explicitTimedOut = explored.stoppedBy == StateSpaceResult::Cancelled && watchdog.fired();
+    json["explicitStoppedBy"] = explicitTimedOut ? "timeout" : limitName(explored.stoppedBy);
+    json["explicitSeconds"] = exploreSeconds;
+    json["explicitDeadlocks"] = explored.deadlocks.size();
+    if (!target.isEmpty()) {
+        // Ответ перебора: найденное состояние — «да» и при неполном обходе
+        bool found = false;
+        if (settings.cover) {
+            for (int i = 0; i < store.size() && !found; ++i) {
+                const int* state = store.state(i);
+                found = true;
+                for (int p = 0; p < net.placeCount() && found; ++p)
+                    found = state[p] >= target[p];
+            }
+        } else {
+            found = store.find(target.constData()) >= 0;
+        }
+        json["explicitMarking"] = found ? "yes" : (explored.complete ? "no" : "unknown");
+    }
+    // Во сколько раз префикс меньше графа достижимости
+    json["compression"] = unfolding.events().isEmpty() ? 0.0 : double(explored.states) / unfolding.events().size();
+    return json;
+}
+
+QJsonObject processFile(const QString& fileName, const Settings& settings)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QJsonObject result;
+    result["file"] = fileName;
+    result["analysis"] = commandName(settings.command);
+
+    PetriNetModel model;
+    QString error;
+    if (!PetriNetModel::loadFromFile(fileName, &model, &error)) {
+        result["ok"] = false;
+        result["error"] = error;
+        return result;
+    }
+    // Ошибки раскрытия подсетей сообщаются здесь, а не теряются в движке
+    const CompiledNet net = CompiledNet::fromModel(model, &error);
+    if (!error.isEmpty()) {
+        result["ok"] = false;
+        result["error"] = error;
+        return result;
+    }
+    result["places"] = net.placeCount();
+    result["transitions"] = net.transitionCount();
+
+    QJsonObject analysis;
+    switch (settings.command) {
+    case Command::Simulate: analysis = simulate(net, settings); break;
+    case Command::Ensemble: analysis = ensemble(net, settings); break;
+    case Command::Reachability: analysis = reachability(net, settings); break;
+    case Command::Invariants: analysis = invariants(net, settings); break;
+    case Command::Unfold: analysis = unfold(net, settings); break;
+    }
+    for (auto it = analysis.begin(); it != analysis.end(); ++it)
+        result[it.key()] = it.value();
+
+    // Анализ сообщает о своей ошибке ключом "ok": false
+    result["ok"] = analysis.value("ok").toBool(true);
+    result["seconds"] = timer.nsecsElapsed() / 1e9;
+    return result;
+}
+
+// Файлы сетей из аргументов; каталоги раскрываются без рекурсии
+QStringList collectFiles(const QStringList& paths, QStringList* missing)
+{
+    QStringList files;
+    for (const QString& path : paths) {
+        const QFileInfo info(path);
+        if (info.isDir()) {
+            const QDir dir(path);
+            for (const QString& name : dir.entryList({"*.pn", "*.json"}, QDir::Files, QDir::Name))
+                files.append(dir.filePath(name));
+        } else if (info.isFile()) {
+            files.append(path);
+        } else {
+            missing->append(path);
+        }
+    }
+    return files;
+}
+
+QByteArray csvField(const QJsonValue& value)
+{
+    QString text;
+    if (value.isBool())
+        text = value.toBool() ? "true" : "false";
+    else if (value.isDouble())
+        text = QString::number(value.toDouble(), 'g', 15);
+    else
+        text = value.toString();
+
+    if (text.contains(',') || text.contains('"') || text.contains('\n'))
+        text = QString("\"%1\"").arg(text.replace('"', "\"\""));
+    return text.toUtf8();
+}
+
+// В CSV попадают только скалярные поля; столбцы — в порядке появления
+QByteArray toCsv(const QVector<QJsonObject>& results)
+{
+    QStringList columns;
+    for (const QJsonObject& result : results) {
+        for (auto it = result.begin(); it != result.end(); ++it) {
+            if (!it.value().isObject() && !it.value().isArray() && !columns.contains(it.key()))
+                columns.append(it.key());
+        }
+    }
+
+    QByteArray csv = columns.join(',').toUtf8() + '\n';
+    for (const QJsonObject& result : results) {
+        QByteArrayList row;
+        for (const QString& column : columns)
+            row.append(csvField(result.value(column)));
+        csv += row.join(',') + '\n';
+    }
+    return csv;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("PetriNetCli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Batch analysis and simulation of saved Petri nets");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "simulate, ensemble, reachability, invariants or unfold.");
+    parser.addPositionalArgument("paths", "Net files or directories with *.pn / *.json files.", "paths...");
+
+    QCommandLineOption threadsOption({"j", "threads"}, "Worker threads (default: all cores).", "n");
+    QCommandLineOption timeoutOption("timeout", "Time limit per model and analysis, seconds.", "seconds");
+    QCommandLineOption stepsOption("steps", "Firings per simulation run (default 100000).", "n");
+    QCommandLineOption timeOption("time", "Model time limit for nets with queue places.", "time");
+    QCommandLineOption runsOption("runs", "Runs in an ensemble (default 100).", "n");
+    QCommandLineOption seedOption("seed", "Random seed of the first run (default 1).", "n");
+    QCommandLineOption maxStatesOption("max-states", "State limit for reachability (default 1000000).", "n");
+    QCommandLineOption maxEventsOption("max-events", "Event limit for unfold (default 200000).", "n");
+    QCommandLineOption markingOption("marking", "Marking to check with unfold, e.g. p1=1,p2=0 (other places empty).",
+                                     "marking");
+    QCommandLineOption coverOption("cover", "With --marking: check coverability instead of exact reachability.");
+    QCommandLineOption maxMemoryOption("max-memory", "Memory limit for reachability, MB.", "mb");
+    QCommandLineOption maxRowsOption("max-rows", "Intermediate row limit for invariants (default 20000).", "n");
+    QCommandLineOption formatOption("format", "Output format: json or csv (default json).", "format", "json");
+    QCommandLineOption outputOption({"o", "output"}, "Write results to <file> instead of stdout.", "file");
+    parser.addOptions({threadsOption, timeoutOption, stepsOption, timeOption, runsOption, seedOption, maxStatesOption, maxEventsOption,
+                       markingOption, coverOption, maxMemoryOption, maxRowsOption, formatOption, outputOption});
+    parser.process(a);
+
+    QTextStream err(stderr);
+    const QStringList args = parser.positionalArguments();
+    if (args.size() < 2) {
+        err << parser.helpText();
+        return 1;
+    }
+
+    Settings settings;
+    const QString command = args.first();
+    if (command == "simulate") settings.command = Command::Simulate;
+    else if (command == "ensemble") settings.command = Command::Ensemble;
+    else if (command == "reachability") settings.command = Command::Reachability;
+    else if (command == "invariants") settings.command = Command::Invariants;
+    else if (command == "unfold") settings.command = Command::Unfold;
+    else {
+        err << "Unknown command: " << command << Qt::endl;
+        return 1;
+    }
+
+    const QString format = parser.value(formatOption);
+    if (format != "json" && format != "csv") {
+        err << "Unknown format: " << format << Qt::endl;
+        return 1;
+    }
+
+    // Числовые параметры: ошибка разбора — ошибка использования
+    bool valid = true;
+    auto number = [&](const QCommandLineOption& option, qint64 fallback) {
+        if (!parser.isSet(option))
+            return fallback;
+        bool ok = false;
+        const qint64 value = parser.value(option).toLongLong(&ok);
+        if (!ok || value < 0) {
+            err << "Invalid value for --" << option.names().last() << ": " << parser.value(option) << Qt::endl;
+            valid = false;
+        }
+        return value;
+    };
+    settings.threads = int(number(threadsOption, QThread::idealThreadCount()));
+    settings.timeoutMs = number(timeoutOption, 0) * 1000;
+    settings.steps = number(stepsOption, settings.steps);
+    settings.runs = int(number(runsOption, settings.runs));
+    if (parser.isSet(timeOption)) {
+        bool ok = false;
+        settings.maxTime = parser.value(timeOption).toDouble(&ok);
+        if (!ok || settings.maxTime < 0) {
+            err << "Invalid value for --time: " << parser.value(timeOption) << Qt::endl;
+            valid = false;
+        }
+    }
+    settings.seed = quint32(number(seedOption, settings.seed));
+    settings.maxStates = int(number(maxStatesOption, settings.maxStates));
+    settings.maxEvents = int(number(maxEventsOption, settings.maxEvents));
+    if (parser.isSet(markingOption) && !parseMarking(parser.value(markingOption), &settings.marking)) {
+        err << "Invalid value for --marking: " << parser.value(markingOption) << Qt::endl;
+        valid = false;
+    }
+    settings.cover = parser.isSet(coverOption);
+    settings.maxMemoryBytes = number(maxMemoryOption, 0) * 1024 * 1024;
+    settings.maxRows = int(number(maxRowsOption, settings.maxRows));
+    if (!valid)
+        return 1;
+
+    QStringList missing;
+    const QStringList files = collectFiles(args.mid(1), &missing);
+    for (const QString& path : missing)
+        err << "Not found: " << path << Qt::endl;
+    if (files.isEmpty()) {
+        err << "No net files to process" << Qt::endl;
+        return 1;
+    }
+
+    // Несколько моделей обрабатываются параллельно, каждая в одном потоке;
+    // одна модель отдаёт все потоки прогонам ансамбля
+    QThreadPool::globalInstance()->setMaxThreadCount(qMax(1, settings.threads));
+    settings.parallelRuns = files.size() == 1;
+
+    std::function<QJsonObject(const QString&)> process = [&settings](const QString& fileName) {
+        return processFile(fileName, settings);
+    };
+    QVector<QJsonObject> results;
+    if (files.size() > 1 && settings.threads > 1) {
+        results = QtConcurrent::blockingMapped<QVector<QJsonObject>>(files, process);
+    } else {
+        for (const QString& fileName : files)
+            results.append(process(fileName));
+    }
+
+    int failed = 0;
+    for (const QJsonObject& result : results) {
+        if (!result["ok"].toBool()) {
+            err << result["file"].toString() << ": " << result["error"].toString() << Qt::endl;
+            failed++;
+        }
+    }
+
+    QByteArray output;
+    if (format == "csv") {
+        output = toCsv(results);
+    } else {
+        QJsonArray list;
+        for (const QJsonObject& result : results)
+            list.append(result);
+        output = QJsonDocument(QJsonObject{{"analysis", commandName(settings.command)}, {"results", list}}).toJson();
+    }
+
+    if (parser.isSet(outputOption)) {
+        QSaveFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly) || file.write(output) != output.size() || !file.commit()) {
+            err << "Cannot write " << file.fileName() << ": " << file.errorString() << Qt::endl;
+            return 1;
+        }
+    } else {
+        QTextStream(stdout) << output;
+    }
+    return failed > 0 ? 2 : 0;
+}
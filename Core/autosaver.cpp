@@ -0,0 +1,222 @@
+// autosaver.cpp
+#include "autosaver.h"
+#include "petriprofiler.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QDateTime>
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonDocument>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+QByteArray changeLine(const QJsonObject& change)
+{
+    return QJsonDocument(change).toJson(QJsonDocument::Compact) + '\n';
+}
+
+QByteArray logHeader(qint64 generation)
+{
+    return changeLine({{"generation", double(generation)}});
+}
+
+// flush() отдаёт данные только ОС; без fsync хвост журнала теряется при сбое питания
+bool syncToDisk(QFile& file)
+{
+    if (!file.flush())
+        return false;
+#ifdef Q_OS_WIN
+    return ::_commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+}
+
+AutoSaver::AutoSaver(const QString &basePath, QObject *parent)
+    : QObject(parent),
+    m_basePath(basePath)
+{
+    m_timer.setInterval(5000);
+    connect(&m_timer, &QTimer::timeout, this, &AutoSaver::flush);
+    connect(&m_watcher, &QFutureWatcher<QString>::finished, this, &AutoSaver::onWriteFinished);
+    m_timer.start();
+}
+
+AutoSaver::~AutoSaver()
+{
+    m_watcher.waitForFinished();
+}
+
+void AutoSaver::setSnapshotProvider(std::function<PetriNetModel ()> provider)
+{
+    m_snapshotProvider = provider;
+}
+
+void AutoSaver::setInterval(int msec)
+{
+    m_timer.setInterval(msec);
+}
+
+void AutoSaver::setCompactionThreshold(int changes)
+{
+    m_compactionThreshold = changes;
+}
+
+QString AutoSaver::snapshotPath() const
+{
+    return m_basePath + ".autosave";
+}
+
+QString AutoSaver::logPath() const
+{
+    return m_basePath + ".autosave.log";
+}
+
+bool AutoSaver::hasRecoveryData() const
+{
+    return QFile::exists(snapshotPath());
+}
+
+bool AutoSaver::recover(PetriNetModel *model, QString *error) const
+{
+    QFile snapshotFile(snapshotPath());
+    if (!snapshotFile.open(QIODevice::ReadOnly)) {
+        if (error) *error = snapshotFile.errorString();
+        return false;
+    }
+    QJsonParseError parseError;
+    QJsonDocument snapshot = QJsonDocument::fromJson(snapshotFile.readAll(), &parseError);
+    if (snapshot.isNull()) {
+        if (error) *error = parseError.errorString();
+        return false;
+    }
+    if (!PetriNetModel::fromJson(snapshot.object(), model, error))
+        return false;
+
+    QFile logFile(logPath());
+    if (!logFile.open(QIODevice::ReadOnly))
+        return true; // Журнала нет — снимок актуален
+
+    // Журнал другого поколения остался от прерванного уплотнения
+    QJsonObject header = QJsonDocument::fromJson(logFile.readLine()).object();
+    if (qint64(header["generation"].toDouble()) != qint64(snapshot.object()["generation"].toDouble()))
+        return true;
+
+    while (!logFile.atEnd()) {
+        QJsonDocument change = QJsonDocument::fromJson(logFile.readLine());
+        // Оборванная последняя строка — запись не успела завершиться
+        if (change.isNull())
+            break;
+        model->applyChange(change.object());
+    }
+    return true;
+}
+
+void AutoSaver::discard()
+{
+    m_watcher.waitForFinished();
+    m_pending.clear();
+    m_changesSinceSnapshot = 0;
+    m_generation = 0;
+    QFile::remove(snapshotPath());
+    QFile::remove(logPath());
+}
+
+void AutoSaver::recordChange(const QJsonObject &change)
+{
+    m_pending.append(change);
+    m_changesSinceSnapshot++;
+}
+
+void AutoSaver::compact()
+{
+    m_compactRequested = true;
+    flush();
+}
+
+void AutoSaver::flush()
+{
+    // Одна фоновая запись за раз; остальное дождётся следующего тика
+    if (m_watcher.isRunning() || !m_snapshotProvider)
+        return;
+
+    if (m_generation == 0 || m_compactRequested || m_changesSinceSnapshot >= m_compactionThreshold) {
+        const PetriNetModel model = m_snapshotProvider();
+        const qint64 generation = qMax(m_generation + 1, QDateTime::currentMSecsSinceEpoch());
+        const QString snapshotPath = this->snapshotPath();
+        const QString logPath = this->logPath();
+
+        m_pending.clear();
+        m_changesSinceSnapshot = 0;
+        m_compactRequested = false;
+        m_generation = generation;
+
+        startWrite([model, generation, snapshotPath, logPath]() -> QString {
+            PETRI_PROFILE_SCOPE("autosave.snapshot");
+            QJsonObject json = model.toJson();
+            json["generation"] = double(generation);
+
+            QSaveFile snapshot(snapshotPath);
+            if (!snapshot.open(QIODevice::WriteOnly))
+                return snapshot.errorString();
+            snapshot.write(QJsonDocument(json).toJson(QJsonDocument::Compact));
+            if (!snapshot.commit())
+                return snapshot.errorString();
+
+            // Новый журнал начинается с заголовка поколения снимка
+            QSaveFile log(logPath);
+            if (!log.open(QIODevice::WriteOnly))
+                return log.errorString();
+            log.write(logHeader(generation));
+            if (!log.commit())
+                return log.errorString();
+            return QString();
+        });
+        return;
+    }
+
+    if (m_pending.isEmpty())
+        return;
+
+    QByteArray batch;
+    for (const QJsonObject& change : m_pending)
+        batch += changeLine(change);
+    m_pending.clear();
+
+    const QString logPath = this->logPath();
+    startWrite([batch, logPath]() -> QString {
+        PETRI_PROFILE_SCOPE("autosave.append");
+        PETRI_PROFILE_COUNT("autosave.appendBytes", batch.size());
+        QFile log(logPath);
+        if (!log.open(QIODevice::WriteOnly | QIODevice::Append))
+            return log.errorString();
+        if (log.write(batch) != batch.size())
+            return log.errorString();
+        if (!syncToDisk(log))
+            return "Cannot sync " + logPath;
+        return QString();
+    });
+}
+
+void AutoSaver::startWrite(std::function<QString ()> job)
+{
+    m_watcher.setFuture(QtConcurrent::run(job));
+}
+
+void AutoSaver::onWriteFinished()
+{
+    const QString error = m_watcher.result();
+    if (!error.isEmpty()) {
+        // Часть журнала могла потеряться — следующий тик запишет полный снимок
+        m_compactRequested = true;
+        emit saveFailed(error);
+    }
+}
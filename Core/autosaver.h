@@ -0,0 +1,66 @@
+#ifndef AUTOSAVER_H
+#define AUTOSAVER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <QJsonObject>
+#include <QVector>
+#include <functional>
+
+#include "petrinetmodel.h"
+
+// Автосохранение: между полными снимками изменения дописываются в журнал
+// (одна JSON-запись на строку), поэтому очередное сохранение стоит O(изменений).
+// Запись на диск выполняется в фоновом потоке, снимок и журнал заменяются
+// атомарно через QSaveFile. Журнал относится к снимку того же поколения.
+class AutoSaver : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AutoSaver(const QString& basePath, QObject *parent = nullptr);
+    ~AutoSaver();
+
+    // Снимок берётся в потоке GUI, сериализуется и пишется в фоне
+    void setSnapshotProvider(std::function<PetriNetModel()> provider);
+
+    void setInterval(int msec);
+    void setCompactionThreshold(int changes);
+
+    QString snapshotPath() const;
+    QString logPath() const;
+
+    bool hasRecoveryData() const;
+    // Загружает последний снимок и проигрывает журнал того же поколения
+    bool recover(PetriNetModel* model, QString* error = nullptr) const;
+
+    // Удаляет файлы автосохранения (при штатном закрытии или новом файле)
+    void discard();
+
+public slots:
+    void recordChange(const QJsonObject& change);
+    // Полный снимок с усечением журнала
+    void compact();
+    void flush();
+
+signals:
+    void saveFailed(const QString& error);
+
+private:
+    void onWriteFinished();
+    void startWrite(std::function<QString()> job);
+
+    QString m_basePath;
+    std::function<PetriNetModel()> m_snapshotProvider;
+
+    QTimer m_timer;
+    QFutureWatcher<QString> m_watcher;
+
+    QVector<QJsonObject> m_pending;
+    int m_changesSinceSnapshot{0};
+    int m_compactionThreshold{1000};
+    qint64 m_generation{0};
+    bool m_compactRequested{false};
+};
+
+#endif // AUTOSAVER_H
@@ -0,0 +1,30 @@
+# Модель сети и движки анализа (только QtCore и QtConcurrent)
+
+# Инструментирование: qmake CONFIG+=profiling
+profiling: DEFINES += PETRI_PROFILING
+
+SOURCES += \
+    $$PWD/autosaver.cpp \
+    $$PWD/invariants.cpp \
+    $$PWD/netgenerators.cpp \
+    $$PWD/netlayout.cpp \
+    $$PWD/petrinetmodel.cpp \
+    $$PWD/petriprofiler.cpp \
+    $$PWD/petrisimulator.cpp \
+    $$PWD/queuesimulator.cpp \
+    $$PWD/statespace.cpp \
+    $$PWD/tokenqueue.cpp \
+    $$PWD/unfolding.cpp
+
+HEADERS += \
+    $$PWD/autosaver.h \
+    $$PWD/invariants.h \
+    $$PWD/netgenerators.h \
+    $$PWD/netlayout.h \
+    $$PWD/petrinetmodel.h \
+    $$PWD/petriprofiler.h \
+    $$PWD/petrisimulator.h \
+    $$PWD/queuesimulator.h \
+    $$PWD/statespace.h \
+    $$PWD/tokenqueue.h \
+    $$PWD/unfolding.h
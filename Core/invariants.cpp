@@ -0,0 +1,191 @@
+// invariants.cpp
+#include "invariants.h"
+#include "petriprofiler.h"
+
+#include <QtGlobal>
+#include <numeric>
+
+namespace {
+
+struct Row {
+    QVector<qint64> a; // Остаток матрицы
+    QVector<qint64> x; // Комбинация исходных строк
+};
+
+// Матрица инцидентности: строки — позиции, столбцы — переходы
+QVector<QVector<qint64>> incidence(const CompiledNet& net)
+{
+    QVector<QVector<qint64>> matrix(net.placeCount(), QVector<qint64>(net.transitionCount(), 0));
+    for (int t = 0; t < net.transitionCount(); ++t) {
+        for (int i = net.inputStart[t]; i < net.inputStart[t + 1]; ++i)
+            matrix[net.inputs[i].place][t] -= net.inputs[i].weight;
+        for (int i = net.outputStart[t]; i < net.outputStart[t + 1]; ++i)
+            matrix[net.outputs[i].place][t] += net.outputs[i].weight;
+    }
+    return matrix;
+}
+
+QVector<QVector<qint64>> transposed(const QVector<QVector<qint64>>& matrix, int columns)
+{
+    QVector<QVector<qint64>> result(columns, QVector<qint64>(matrix.size(), 0));
+    for (int i = 0; i < matrix.size(); ++i) {
+        for (int j = 0; j < columns; ++j)
+            result[j][i] = matrix[i][j];
+    }
+    return result;
+}
+
+// a * x + b * y; false при переполнении qint64
+bool combine(qint64 a, qint64 x, qint64 b, qint64 y, qint64* result)
+{
+    qint64 first;
+    qint64 second;
+#if defined(Q_CC_GNU) || defined(Q_CC_CLANG)
+    return !__builtin_mul_overflow(a, x, &first) && !__builtin_mul_overflow(b, y, &second)
+        && !__builtin_add_overflow(first, second, result);
+#else
+    return !qMulOverflow(a, x, &first) && !qMulOverflow(b, y, &second)
+        && !qAddOverflow(first, second, result);
+#endif
+}
+
+void normalize(Row* row)
+{
+    qint64 divisor = 0;
+    for (qint64 value : row->a)
+        divisor = std::gcd(divisor, value);
+    for (qint64 value : row->x)
+        divisor = std::gcd(divisor, value);
+    if (divisor > 1) {
+        for (qint64& value : row->a) value /= divisor;
+        for (qint64& value : row->x) value /= divisor;
+    }
+}
+
+// Носитель first содержится в носителе second
+bool supportWithin(const QVector<qint64>& first, const QVector<qint64>& second)
+{
+    for (int i = 0; i < first.size(); ++i) {
+        if (first[i] != 0 && second[i] == 0)
+            return false;
+    }
+    return true;
+}
+
+// Добавление строки с сохранением минимальности носителей
+void appendMinimal(QVector<Row>* rows, Row row)
+{
+    for (const Row& existing : *rows) {
+        if (supportWithin(existing.x, row.x))
+            return;
+    }
+    for (int i = rows->size() - 1; i >= 0; --i) {
+        if (supportWithin(row.x, (*rows)[i].x)) {
+            (*rows)[i] = rows->last();
+            rows->removeLast();
+        }
+    }
+    rows->append(row);
+}
+
+InvariantResult farkas(const QVector<QVector<qint64>>& matrix, int columns, int maxRows,
+                       const std::atomic<bool>* cancel)
+{
+    InvariantResult result;
+    const int n = matrix.size();
+
+    QVector<Row> rows;
+    for (int i = 0; i < n; ++i) {
+        Row row;
+        row.a = matrix[i];
+        row.x = QVector<qint64>(n, 0);
+        row.x[i] = 1;
+        rows.append(row);
+    }
+
+    for (int j = 0; j < columns && result.complete; ++j) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            result.complete = false;
+            break;
+        }
+
+        QVector<Row> next;
+        QVector<int> positive;
+        QVector<int> negative;
+        for (int i = 0; i < rows.size(); ++i) {
+            if (rows[i].a[j] == 0)
+                next.append(rows[i]);
+            else
+                (rows[i].a[j] > 0 ? positive : negative).append(i);
+        }
+
+        // Комбинации с положительными множителями обнуляют столбец j
+        for (int p : positive) {
+            for (int q : negative) {
+                const Row& first = rows[p];
+                const Row& second = rows[q];
+                const qint64 firstFactor = -second.a[j];
+                const qint64 secondFactor = first.a[j];
+
+                // Переполнение дало бы ложные инварианты — результат неполон
+                Row row;
+                row.a.resize(columns);
+                row.x.resize(n);
+                bool exact = true;
+                for (int k = 0; k < columns && exact; ++k)
+                    exact = combine(firstFactor, first.a[k], secondFactor, second.a[k], &row.a[k]);
+                for (int k = 0; k < n && exact; ++k)
+                    exact = combine(firstFactor, first.x[k], secondFactor, second.x[k], &row.x[k]);
+                if (!exact) {
+                    result.complete = false;
+                    break;
+                }
+                normalize(&row);
+                appendMinimal(&next, row);
+            }
+            if (!result.complete)
+                break;
+            if (next.size() > maxRows) {
+                result.complete = false;
+                break;
+            }
+        }
+        rows = next;
+    }
+
+    // При досрочной остановке остаются и строки с ненулевым остатком
+    for (const Row& row : rows) {
+        bool zero = true;
+        for (qint64 value : row.a) {
+            if (value != 0) {
+                zero = false;
+                break;
+            }
+        }
+        if (zero)
+            result.invariants.append(row.x);
+    }
+
+    result.covered.fill(false, n);
+    for (const QVector<qint64>& invariant : result.invariants) {
+        for (int i = 0; i < n; ++i) {
+            if (invariant[i] != 0)
+                result.covered[i] = true;
+        }
+    }
+    return result;
+}
+
+}
+
+InvariantResult Invariants::placeInvariants(const CompiledNet &net, int maxRows, const std::atomic<bool> *cancel)
+{
+    PETRI_PROFILE_SCOPE("invariants.place");
+    return farkas(incidence(net), net.transitionCount(), maxRows, cancel);
+}
+
+InvariantResult Invariants::transitionInvariants(const CompiledNet &net, int maxRows, const std::atomic<bool> *cancel)
+{
+    PETRI_PROFILE_SCOPE("invariants.transition");
+    return farkas(transposed(incidence(net), net.transitionCount()), net.placeCount(), maxRows, cancel);
+}
@@ -0,0 +1,29 @@
+#ifndef INVARIANTS_H
+#define INVARIANTS_H
+
+#include <QVector>
+#include <atomic>
+
+#include "petrisimulator.h"
+
+struct InvariantResult {
+    // Минимальные полуположительные инварианты; длина вектора —
+    // число позиций (P-инварианты) или переходов (T-инварианты)
+    QVector<QVector<qint64>> invariants;
+    bool complete{true};   // false — превышен лимит промежуточных строк
+    QVector<bool> covered; // Элемент входит в носитель хотя бы одного инварианта
+};
+
+// Инварианты по алгоритму Фаркаша над матрицей инцидентности
+// C[p][t] = W(t, p) - W(p, t). Промежуточные строки с неминимальным
+// носителем отбрасываются сразу, что сдерживает рост их числа.
+namespace Invariants {
+
+InvariantResult placeInvariants(const CompiledNet& net, int maxRows = 20000,
+                                const std::atomic<bool>* cancel = nullptr);
+InvariantResult transitionInvariants(const CompiledNet& net, int maxRows = 20000,
+                                     const std::atomic<bool>* cancel = nullptr);
+
+}
+
+#endif // INVARIANTS_H
@@ -0,0 +1,248 @@
+// netgenerators.cpp
+#include "netgenerators.h"
+
+#include <QRandomGenerator>
+#include <QtMath>
+
+namespace {
+
+const qreal Step = 80;
+
+// Добавление элементов с последовательными id
+class NetBuilder
+{
+public:
+    int place(const QString& label, qreal x, qreal y, int tokens = 0)
+    {
+        PlaceData place;
+        place.id = m_model.nextId++;
+        place.label = label;
+        place.pos = QPointF(x, y);
+        place.tokens = tokens;
+        m_model.places.append(place);
+        return place.id;
+    }
+
+    int transition(const QString& label, qreal x, qreal y)
+    {
+        TransitionData transition;
+        transition.id = m_model.nextId++;
+        transition.label = label;
+        transition.pos = QPointF(x, y);
+        m_model.transitions.append(transition);
+        return transition.id;
+    }
+
+    void input(int place, int transition, int weight = 1) { arc(place, transition, true, weight); }
+    void output(int transition, int place, int weight = 1) { arc(place, transition, false, weight); }
+
+    PetriNetModel take()
+    {
+        m_model.rebuildIndex();
+        return m_model;
+    }
+
+private:
+    void arc(int place, int transition, bool fromPlace, int weight)
+    {
+        ArcData arc;
+        arc.id = m_model.nextId++;
+        arc.place = place;
+        arc.transition = transition;
+        arc.fromPlace = fromPlace;
+        arc.weight = weight;
+        m_model.arcs.append(arc);
+    }
+
+    PetriNetModel m_model;
+};
+
+QPointF onCircle(int index, int count, qreal radius)
+{
+    const qreal angle = 2 * M_PI * index / qMax(1, count);
+    return QPointF(radius * qCos(angle), radius * qSin(angle));
+}
+
+}
+
+PetriNetModel NetGenerators::diningPhilosophers(int philosophers)
+{
+    NetBuilder net;
+    const int n = qMax(2, philosophers);
+    const qreal radius = Step * n / M_PI;
+
+    QVector<int> forks;
+    for (int i = 0; i < n; ++i) {
+        const QPointF pos = onCircle(2 * i + 1, 2 * n, radius);
+        forks.append(net.place(QString("fork%1").arg(i), pos.x(), pos.y(), 1));
+    }
+
+    for (int i = 0; i < n; ++i) {
+        const QPointF pos = onCircle(2 * i, 2 * n, radius);
+        const QPointF out = onCircle(2 * i, 2 * n, radius + 2 * Step);
+        const QPointF dir = (out - pos) / 2;
+
+        const int think = net.place(QString("think%1").arg(i), out.x(), out.y(), 1);
+        const int left = net.place(QString("left%1").arg(i), pos.x() + dir.x() + dir.y(), pos.y() + dir.y() - dir.x());
+        const int eat = net.place(QString("eat%1").arg(i), pos.x(), pos.y());
+
+        const int takeLeft = net.transition(QString("takeLeft%1").arg(i), out.x() - dir.x() + dir.y(), out.y() - dir.y() - dir.x());
+        const int takeRight = net.transition(QString("takeRight%1").arg(i), pos.x() + dir.y(), pos.y() - dir.x());
+        const int release = net.transition(QString("release%1").arg(i), pos.x() + dir.x() - dir.y(), pos.y() + dir.y() + dir.x());
+
+        const int leftFork = forks[i];
+        const int rightFork = forks[(i + 1) % n];
+
+        net.input(think, takeLeft);
+        net.input(leftFork, takeLeft);
+        net.output(takeLeft, left);
+
+        net.input(left, takeRight);
+        net.input(rightFork, takeRight);
+        net.output(takeRight, eat);
+
+        net.input(eat, release);
+        net.output(release, think);
+        net.output(release, leftFork);
+        net.output(release, rightFork);
+    }
+    return net.take();
+}
+
+PetriNetModel NetGenerators::pipeline(int stages, int tokens)
+{
+    NetBuilder net;
+    const int n = qMax(1, stages);
+
+    // Очереди между стадиями и свободные места стадий
+    QVector<int> queues;
+    for (int k = 0; k <= n; ++k)
+        queues.append(net.place(QString("q%1").arg(k), 2 * k * Step, 0, k == 0 ? qMax(0, tokens) : 0));
+
+    QVector<int> slots;
+    for (int k = 0; k < n; ++k)
+        slots.append(net.place(QString("free%1").arg(k), (2 * k + 1) * Step, Step, 1));
+
+    for (int k = 0; k < n; ++k) {
+        const int start = net.transition(QString("start%1").arg(k), (2 * k + 1) * Step - Step / 2, -Step);
+        const int busy = net.place(QString("busy%1").arg(k), (2 * k + 1) * Step, -Step);
+        const int finish = net.transition(QString("finish%1").arg(k), (2 * k + 1) * Step + Step / 2, -Step);
+
+        net.input(queues[k], start);
+        net.input(slots[k], start);
+        net.output(start, busy);
+
+        net.input(busy, finish);
+        net.output(finish, queues[k + 1]);
+        net.output(finish, slots[k]);
+    }
+
+    // Возврат заявок в начало делает конвейер замкнутым
+    const int back = net.transition("back", n * Step, 2 * Step);
+    net.input(queues[n], back);
+    net.output(back, queues[0]);
+    return net.take();
+}
+
+PetriNetModel NetGenerators::randomSparse(int places, int transitions, quint32 seed)
+{
+    NetBuilder net;
+    QRandomGenerator random(seed);
+    const int placeCount = qMax(1, places);
+    const int transitionCount = qMax(1, transitions);
+    const int columns = qMax(1, int(qSqrt(placeCount + transitionCount)));
+
+    int cell = 0;
+    auto nextPos = [&]() {
+        const QPointF pos((cell % columns) * Step, (cell / columns) * Step);
+        cell++;
+        return pos;
+    };
+
+    QVector<int> placeIds;
+    for (int i = 0; i < placeCount; ++i) {
+        const QPointF pos = nextPos();
+        placeIds.append(net.place(QString("p%1").arg(i), pos.x(), pos.y(), int(random.bounded(3))));
+    }
+
+    for (int i = 0; i < transitionCount; ++i) {
+        const QPointF pos = nextPos();
+        const int transition = net.transition(QString("t%1").arg(i), pos.x(), pos.y());
+
+        const int first = int(random.bounded(placeCount));
+        net.input(placeIds[first], transition);
+        if (placeCount > 1 && random.bounded(2) == 0)
+            net.input(placeIds[(first + 1 + int(random.bounded(placeCount - 1))) % placeCount], transition);
+
+        const int target = int(random.bounded(placeCount));
+        net.output(transition, placeIds[target]);
+        if (placeCount > 1 && random.bounded(2) == 0)
+            net.output(transition, placeIds[(target + 1 + int(random.bounded(placeCount - 1))) % placeCount]);
+    }
+    return net.take();
+}
+
+PetriNetModel NetGenerators::grid(int width, int height)
+{
+    NetBuilder net;
+    const int w = qMax(1, width);
+    const int h = qMax(1, height);
+
+    // По одной фишке в первом столбце каждой строки
+    QVector<int> cells;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x)
+            cells.append(net.place(QString("p%1_%2").arg(x).arg(y), 2 * x * Step, 2 * y * Step, x == 0 ? 1 : 0));
+    }
+
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            const int from = cells[y * w + x];
+
+            const int right = net.transition(QString("r%1_%2").arg(x).arg(y), (2 * x + 1) * Step, 2 * y * Step);
+            net.input(from, right);
+            net.output(right, cells[y * w + (x + 1) % w]);
+
+            const int down = net.transition(QString("d%1_%2").arg(x).arg(y), 2 * x * Step, (2 * y + 1) * Step);
+            net.input(from, down);
+            net.output(down, cells[((y + 1) % h) * w + x]);
+        }
+    }
+    return net.take();
+}
+
+PetriNetModel NetGenerators::producerConsumer(int producers, int consumers)
+{
+    NetBuilder net;
+    const int rows = qMax(qMax(1, producers), qMax(1, consumers));
+    const int buffer = net.place("buffer", 3 * Step, (rows - 1) * Step, 0);
+
+    for (int i = 0; i < qMax(1, producers); ++i) {
+        const qreal y = 2 * i * Step;
+        const int idle = net.place(QString("idle%1").arg(i), 0, y, 1);
+        const int ready = net.place(QString("ready%1").arg(i), Step, y + Step);
+        const int produce = net.transition(QString("produce%1").arg(i), 0, y + Step);
+        const int deliver = net.transition(QString("deliver%1").arg(i), 2 * Step, y);
+
+        net.input(idle, produce);
+        net.output(produce, ready);
+        net.input(ready, deliver);
+        net.output(deliver, idle);
+        net.output(deliver, buffer);
+    }
+
+    for (int j = 0; j < qMax(1, consumers); ++j) {
+        const qreal y = 2 * j * Step;
+        const int wait = net.place(QString("wait%1").arg(j), 6 * Step, y, 1);
+        const int busy = net.place(QString("busy%1").arg(j), 5 * Step, y + Step);
+        const int consume = net.transition(QString("consume%1").arg(j), 4 * Step, y);
+        const int finish = net.transition(QString("finish%1").arg(j), 6 * Step, y + Step);
+
+        net.input(wait, consume);
+        net.input(buffer, consume);
+        net.output(consume, busy);
+        net.input(busy, finish);
+        net.output(finish, wait);
+    }
+    return net.take();
+}
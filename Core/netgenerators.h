@@ -0,0 +1,27 @@
+#ifndef NETGENERATORS_H
+#define NETGENERATORS_H
+
+#include "petrinetmodel.h"
+
+// Параметризованные синтетические сети для бенчмарков и проверки движков.
+// Элементы получают координаты, поэтому сети можно открыть в редакторе.
+namespace NetGenerators {
+
+// n философов; вилки берутся по одной, поэтому сеть может зайти в тупик
+PetriNetModel diningPhilosophers(int philosophers);
+
+// Конвейер из stages стадий с tokens заявками; ёмкость стадии — 1
+PetriNetModel pipeline(int stages, int tokens);
+
+// Случайная разреженная сеть: у каждого перехода 1–2 входа и 1–2 выхода
+PetriNetModel randomSparse(int places, int transitions, quint32 seed);
+
+// Решётка width x height на торе: фишки перемещаются вправо и вниз
+PetriNetModel grid(int width, int height);
+
+// Производители и потребители с общим неограниченным буфером
+PetriNetModel producerConsumer(int producers, int consumers);
+
+}
+
+#endif // NETGENERATORS_H
@@ -0,0 +1,566 @@
+// netlayout.cpp
+#include "netlayout.h"
+#include "petriprofiler.h"
+
+#include <QHash>
+#include <QThreadPool>
+#include <QRandomGenerator>
+#include <QtMath>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// Делит [0, count) на блоки и выполняет их на пуле потоков
+template <typename Function>
+void parallelFor(QThreadPool& pool, int count, Function function)
+{
+    const int blocks = qMax(1, qMin(pool.maxThreadCount(), count / 256));
+    if (blocks == 1) {
+        function(0, count);
+        return;
+    }
+    const int blockSize = (count + blocks - 1) / blocks;
+    for (int b = 0; b < blocks; ++b) {
+        const int begin = b * blockSize;
+        const int end = qMin(count, begin + blockSize);
+        pool.start([function, begin, end]() { function(begin, end); });
+    }
+    pool.waitForDone();
+}
+
+// Квадродерево Barnes–Hut в плоском массиве. Масса ячейки хранится
+// раздельно для позиций и переходов, чтобы учитывать двудольность.
+class QuadTree
+{
+public:
+    struct Cell {
+        double cx, cy, half;
+        double sumX{0}, sumY{0};
+        int mass[2]{0, 0};
+        int count{0};
+        int child{-1}; // Индекс первого из четырёх потомков
+        int body{-1};
+    };
+
+    QuadTree(const QVector<QPointF>& positions, const LayoutGraph& graph)
+        : m_positions(positions),
+        m_graph(graph)
+    {
+        m_cells.reserve(positions.size() * 3);
+    }
+
+    // Перестройка по текущим позициям; память ячеек сохраняется между итерациями
+    void build()
+    {
+        PETRI_PROFILE_SCOPE("layout.quadtree");
+        const QVector<QPointF>& positions = m_positions;
+        m_cells.clear();
+        double minX = positions[0].x(), maxX = minX;
+        double minY = positions[0].y(), maxY = minY;
+        for (const QPointF& p : positions) {
+            minX = qMin(minX, p.x()); maxX = qMax(maxX, p.x());
+            minY = qMin(minY, p.y()); maxY = qMax(maxY, p.y());
+        }
+        Cell root;
+        root.cx = (minX + maxX) / 2;
+        root.cy = (minY + maxY) / 2;
+        root.half = qMax(maxX - minX, maxY - minY) / 2 + 1.0;
+        m_cells.push_back(root);
+        for (int i = 0; i < positions.size(); ++i)
+            insert(i);
+    }
+
+    const std::vector<Cell>& cells() const { return m_cells; }
+
+private:
+    int kind(int body) const { return m_graph.isPlace(body) ? 0 : 1; }
+
+    void addBody(int c, int body)
+    {
+        Cell& cell = m_cells[c];
+        cell.sumX += m_positions[body].x();
+        cell.sumY += m_positions[body].y();
+        cell.mass[kind(body)]++;
+        cell.count++;
+    }
+
+    int childFor(int c, const QPointF& p) const
+    {
+        const Cell& cell = m_cells[c];
+        return cell.child + (p.x() >= cell.cx ? 1 : 0) + (p.y() >= cell.cy ? 2 : 0);
+    }
+
+    void subdivide(int c)
+    {
+        const double half = m_cells[c].half / 2;
+        const double cx = m_cells[c].cx;
+        const double cy = m_cells[c].cy;
+        m_cells[c].child = int(m_cells.size());
+        for (int q = 0; q < 4; ++q) {
+            Cell cell;
+            cell.cx = cx + ((q & 1) ? half : -half);
+            cell.cy = cy + ((q & 2) ? half : -half);
+            cell.half = half;
+            m_cells.push_back(cell);
+        }
+    }
+
+    void insert(int body)
+    {
+        int c = 0;
+        for (;;) {
+            addBody(c, body);
+            if (m_cells[c].child < 0) {
+                if (m_cells[c].count == 1) {
+                    m_cells[c].body = body;
+                    return;
+                }
+                // Совпадающие узлы остаются агрегированным листом
+                if (m_cells[c].half < 1e-3) {
+                    m_cells[c].body = -1;
+                    return;
+                }
+                const int other = m_cells[c].body;
+                subdivide(c);
+                m_cells[c].body = -1;
+                if (other >= 0) {
+                    const int otherCell = childFor(c, m_positions[other]);
+                    addBody(otherCell, other);
+                    m_cells[otherCell].body = other;
+                }
+            }
+            c = childFor(c, m_positions[body]);
+        }
+    }
+
+    const QVector<QPointF>& m_positions;
+    const LayoutGraph& m_graph;
+    std::vector<Cell> m_cells;
+};
+
+QVector<QPointF> initialPositions(const LayoutGraph& graph, const QVector<QPointF>& initial, double edgeLength)
+{
+    const int n = graph.nodeCount();
+    bool usable = initial.size() == n;
+    if (usable) {
+        // Импортированные сети часто приходят без координат — все узлы в одной точке
+        double minX = initial[0].x(), maxX = minX;
+        double minY = initial[0].y(), maxY = minY;
+        for (const QPointF& p : initial) {
+            minX = qMin(minX, p.x()); maxX = qMax(maxX, p.x());
+            minY = qMin(minY, p.y()); maxY = qMax(maxY, p.y());
+        }
+        usable = (maxX - minX) * (maxY - minY) > edgeLength * edgeLength * n * 0.01;
+    }
+
+    QRandomGenerator random(12345);
+    QVector<QPointF> positions(n);
+    const double radius = edgeLength * qSqrt(double(n));
+    for (int i = 0; i < n; ++i) {
+        // Небольшой сдвиг разводит совпадающие узлы
+        const QPointF jitter(random.bounded(1.0), random.bounded(1.0));
+        if (usable) {
+            positions[i] = initial[i] + jitter;
+        } else {
+            const double r = radius * qSqrt(random.bounded(1.0));
+            const double angle = random.bounded(2 * M_PI);
+            positions[i] = QPointF(r * qCos(angle), r * qSin(angle)) + jitter;
+        }
+    }
+    return positions;
+}
+
+}
+
+LayoutGraph LayoutGraph::fromModel(const PetriNetModel &model)
+{
+    LayoutGraph graph;
+    graph.placeCount = model.places.size();
+    graph.transitionCount = model.transitions.size();
+    graph.nodeIds.reserve(graph.nodeCount());
+
+    QHash<int, int> placeNodes;
+    QHash<int, int> transitionNodes;
+    for (const PlaceData& place : model.places) {
+        placeNodes.insert(place.id, graph.nodeIds.size());
+        graph.nodeIds.append(place.id);
+    }
+    for (const TransitionData& transition : model.transitions) {
+        transitionNodes.insert(transition.id, graph.nodeIds.size());
+        graph.nodeIds.append(transition.id);
+    }
+
+    graph.edges.reserve(model.arcs.size());
+    for (const ArcData& arc : model.arcs) {
+        const int place = placeNodes.value(arc.place, -1);
+        const int transition = transitionNodes.value(arc.transition, -1);
+        if (place < 0 || transition < 0) continue;
+        if (arc.fromPlace)
+            graph.edges.append({place, transition});
+        else
+            graph.edges.append({transition, place});
+    }
+    graph.buildAdjacency();
+    return graph;
+}
+
+void LayoutGraph::buildAdjacency()
+{
+    const int n = nodeCount();
+    adjacencyStart.fill(0, n + 1);
+    for (const auto& edge : edges) {
+        adjacencyStart[edge.first + 1]++;
+        adjacencyStart[edge.second + 1]++;
+    }
+    for (int v = 0; v < n; ++v)
+        adjacencyStart[v + 1] += adjacencyStart[v];
+
+    adjacency.resize(edges.size() * 2);
+    QVector<int> fill = adjacencyStart;
+    for (const auto& edge : edges) {
+        adjacency[fill[edge.first]++] = edge.second;
+        adjacency[fill[edge.second]++] = edge.first;
+    }
+}
+
+QVector<QPointF> NetLayout::forceDirected(const LayoutGraph &graph, const QVector<QPointF> &initial,
+                                          const LayoutOptions &options, const Progress &progress)
+{
+    PETRI_PROFILE_SCOPE("layout.forceDirected");
+    const int n = graph.nodeCount();
+    if (n == 0)
+        return {};
+
+    QThreadPool pool;
+    if (options.threads > 0)
+        pool.setMaxThreadCount(options.threads);
+
+    QVector<QPointF> positions = initialPositions(graph, initial, options.edgeLength);
+    QVector<QPointF> displacement(n);
+
+    // Фрухтерман–Рейнгольд: отталкивание k^2/d, притяжение d^2/k
+    const double k = options.edgeLength;
+    const double k2 = k * k;
+    const double theta2 = options.theta * options.theta;
+    const double gravity = 0.01;
+    double temperature = k * qSqrt(double(n)) / 4;
+    const double cooling = qPow(0.01, 1.0 / qMax(1, options.iterations));
+
+    QuadTree tree(positions, graph);
+    for (int iteration = 0; iteration < options.iterations; ++iteration) {
+        tree.build();
+        const std::vector<QuadTree::Cell>& cells = tree.cells();
+
+        parallelFor(pool, n, [&](int begin, int end) {
+            std::vector<int> stack;
+            for (int v = begin; v < end; ++v) {
+                const QPointF p = positions[v];
+                const int same = graph.isPlace(v) ? 0 : 1;
+                double fx = 0, fy = 0;
+
+                // Отталкивание по дереву
+                stack.clear();
+                stack.push_back(0);
+                while (!stack.empty()) {
+                    const QuadTree::Cell& cell = cells[stack.back()];
+                    stack.pop_back();
+                    if (cell.count == 0 || (cell.child < 0 && cell.body == v))
+                        continue;
+
+                    const double comX = cell.sumX / cell.count;
+                    const double comY = cell.sumY / cell.count;
+                    const double dx = p.x() - comX;
+                    const double dy = p.y() - comY;
+                    const double d2 = dx * dx + dy * dy;
+                    const double size = 2 * cell.half;
+
+                    if (cell.child < 0 || size * size < theta2 * d2) {
+                        if (d2 < 1e-6)
+                            continue;
+                        const double weight = cell.mass[same] + options.crossKindRepulsion * cell.mass[1 - same];
+                        const double f = k2 * weight / d2;
+                        fx += dx * f;
+                        fy += dy * f;
+                    } else {
+                        for (int q = 0; q < 4; ++q)
+                            stack.push_back(cell.child + q);
+                    }
+                }
+
+                // Притяжение вдоль дуг
+                for (int e = graph.adjacencyStart[v]; e < graph.adjacencyStart[v + 1]; ++e) {
+                    const QPointF q = positions[graph.adjacency[e]];
+                    const double dx = q.x() - p.x();
+                    const double dy = q.y() - p.y();
+                    const double d = qSqrt(dx * dx + dy * dy);
+                    fx += dx * d / k;
+                    fy += dy * d / k;
+                }
+
+                // Слабое притяжение к центру удерживает несвязные компоненты
+                fx -= gravity * p.x();
+                fy -= gravity * p.y();
+
+                displacement[v] = QPointF(fx, fy);
+            }
+        });
+
+        // data() отделяет общий с последним кадром буфер до запуска потоков
+        QPointF* moved = positions.data();
+        parallelFor(pool, n, [&](int begin, int end) {
+            for (int v = begin; v < end; ++v) {
+                const QPointF d = displacement[v];
+                const double length = qSqrt(d.x() * d.x() + d.y() * d.y());
+                if (length > 0)
+                    moved[v] += d * (qMin(length, temperature) / length);
+            }
+        });
+        temperature *= cooling;
+
+        if (progress && (iteration + 1) % qMax(1, options.progressInterval) == 0) {
+            if (!progress(positions))
+                break;
+        }
+    }
+    return positions;
+}
+
+QVector<QPointF> NetLayout::layered(const LayoutGraph &graph, const LayoutOptions &options)
+{
+    PETRI_PROFILE_SCOPE("layout.layered");
+    const int n = graph.nodeCount();
+    if (n == 0)
+        return {};
+
+    QVector<QVector<int>> out(n);
+    for (const auto& edge : graph.edges)
+        out[edge.first].append(edge.second);
+
+    // 1. Разрыв циклов: обратные дуги DFS разворачиваются
+    QVector<QPair<int, int>> dag;
+    dag.reserve(graph.edges.size());
+    {
+        QVector<char> state(n, 0); // 0 — не посещён, 1 — в стеке, 2 — завершён
+        QVector<QPair<int, int>> stack; // (узел, следующий индекс потомка)
+        for (int root = 0; root < n; ++root) {
+            if (state[root]) continue;
+            stack.append({root, 0});
+            state[root] = 1;
+            while (!stack.isEmpty()) {
+                auto& top = stack.last();
+                const int v = top.first;
+                if (top.second < out[v].size()) {
+                    const int u = out[v][top.second++];
+                    if (state[u] == 1) {
+                        dag.append({u, v});
+                    } else {
+                        dag.append({v, u});
+                        if (state[u] == 0) {
+                            state[u] = 1;
+                            stack.append({u, 0});
+                        }
+                    }
+                } else {
+                    state[v] = 2;
+                    stack.removeLast();
+                }
+            }
+        }
+    }
+
+    // 2. Слои по самому длинному пути (топологический порядок Кана)
+    QVector<int> layer(n, 0);
+    {
+        QVector<QVector<int>> succ(n);
+        QVector<int> indegree(n, 0);
+        for (const auto& edge : dag) {
+            if (edge.first == edge.second) continue;
+            succ[edge.first].append(edge.second);
+            indegree[edge.second]++;
+        }
+        QVector<int> queue;
+        queue.reserve(n);
+        for (int v = 0; v < n; ++v) {
+            if (indegree[v] == 0)
+                queue.append(v);
+        }
+        for (int head = 0; head < queue.size(); ++head) {
+            const int v = queue[head];
+            for (int u : succ[v]) {
+                layer[u] = qMax(layer[u], layer[v] + 1);
+                if (--indegree[u] == 0)
+                    queue.append(u);
+            }
+        }
+    }
+
+    // 3. Длинные дуги разбиваются фиктивными узлами (индексы >= n)
+    QVector<int> nodeLayer = layer;
+    QVector<QVector<int>> up(n);   // соседи в предыдущем слое
+    QVector<QVector<int>> down(n); // соседи в следующем слое
+    for (const auto& edge : dag) {
+        int from = edge.first;
+        const int to = edge.second;
+        if (from == to) continue;
+        for (int l = nodeLayer[from] + 1; l < nodeLayer[to]; ++l) {
+            const int dummy = nodeLayer.size();
+            nodeLayer.append(l);
+            up.append(QVector<int>{from});
+            down.append(QVector<int>());
+            down[from].append(dummy);
+            from = dummy;
+        }
+        down[from].append(to);
+        up[to].append(from);
+    }
+
+    const int total = nodeLayer.size();
+    int layerCount = 0;
+    for (int l : nodeLayer)
+        layerCount = qMax(layerCount, l + 1);
+    QVector<QVector<int>> layers(layerCount);
+    for (int v = 0; v < total; ++v)
+        layers[nodeLayer[v]].append(v);
+
+    // 4. Уменьшение пересечений методом барицентров
+    QVector<double> order(total);
+    for (const QVector<int>& nodes : layers) {
+        for (int i = 0; i < nodes.size(); ++i)
+            order[nodes[i]] = i;
+    }
+    auto sweep = [&](int l, const QVector<QVector<int>>& neighbours) {
+        QVector<int>& nodes = layers[l];
+        QVector<double> barycenter(nodes.size());
+        for (int i = 0; i < nodes.size(); ++i) {
+            const QVector<int>& adjacent = neighbours[nodes[i]];
+            if (adjacent.isEmpty()) {
+                barycenter[i] = order[nodes[i]];
+                continue;
+            }
+            double sum = 0;
+            for (int u : adjacent)
+                sum += order[u];
+            barycenter[i] = sum / adjacent.size();
+        }
+        QVector<int> index(nodes.size());
+        for (int i = 0; i < index.size(); ++i)
+            index[i] = i;
+        std::stable_sort(index.begin(), index.end(), [&](int a, int b) { return barycenter[a] < barycenter[b]; });
+        QVector<int> sorted(nodes.size());
+        for (int i = 0; i < index.size(); ++i) {
+            sorted[i] = nodes[index[i]];
+            order[sorted[i]] = i;
+        }
+        nodes = sorted;
+    };
+    for (int pass = 0; pass < 12; ++pass) {
+        for (int l = 1; l < layerCount; ++l)
+            sweep(l, up);
+        for (int l = layerCount - 2; l >= 0; --l)
+            sweep(l, down);
+    }
+
+    // 5. Координаты: слои по горизонтали, внутри слоя — выравнивание
+    //    по медиане соседей с сохранением порядка и минимального шага
+    QVector<double> y(total);
+    for (const QVector<int>& nodes : layers) {
+        for (int i = 0; i < nodes.size(); ++i)
+            y[nodes[i]] = (i - (nodes.size() - 1) / 2.0) * options.nodeSpacing;
+    }
+    auto align = [&](int l, const QVector<QVector<int>>& neighbours) {
+        const QVector<int>& nodes = layers[l];
+        if (nodes.isEmpty()) return;
+        QVector<double> desired(nodes.size());
+        for (int i = 0; i < nodes.size(); ++i) {
+            const QVector<int>& adjacent = neighbours[nodes[i]];
+            if (adjacent.isEmpty()) {
+                desired[i] = y[nodes[i]];
+                continue;
+            }
+            QVector<double> values;
+            for (int u : adjacent)
+                values.append(y[u]);
+            std::sort(values.begin(), values.end());
+            const int m = values.size();
+            desired[i] = m % 2 ? values[m / 2] : (values[m / 2 - 1] + values[m / 2]) / 2;
+        }
+        // Проход вниз и вверх с минимальным шагом; результат — среднее двух
+        QVector<double> forward = desired;
+        for (int i = 1; i < forward.size(); ++i)
+            forward[i] = qMax(forward[i], forward[i - 1] + options.nodeSpacing);
+        QVector<double> backward = desired;
+        for (int i = backward.size() - 2; i >= 0; --i)
+            backward[i] = qMin(backward[i], backward[i + 1] - options.nodeSpacing);
+        for (int i = 0; i < nodes.size(); ++i)
+            y[nodes[i]] = (forward[i] + backward[i]) / 2;
+    };
+    for (int pass = 0; pass < 4; ++pass) {
+        for (int l = 1; l < layerCount; ++l)
+            align(l, up);
+        for (int l = layerCount - 2; l >= 0; --l)
+            align(l, down);
+    }
+
+    QVector<QPointF> positions(n);
+    for (int v = 0; v < n; ++v)
+        positions[v] = QPointF(layer[v] * options.layerSpacing, y[v]);
+    return positions;
+}
+
+LayoutRunner::LayoutRunner(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<QVector<QPointF>>("QVector<QPointF>");
+}
+
+LayoutRunner::~LayoutRunner()
+{
+    cancel();
+    if (m_thread)
+        m_thread->wait();
+    delete m_thread;
+}
+
+bool LayoutRunner::isRunning() const
+{
+    return m_thread && m_thread->isRunning();
+}
+
+quint64 LayoutRunner::start(const LayoutGraph &graph, const QVector<QPointF> &initial, const LayoutOptions &options)
+{
+    cancel();
+    if (m_thread)
+        m_thread->wait();
+    delete m_thread;
+
+    m_cancelled = false;
+    m_framePending = false;
+    const quint64 generation = ++m_generation;
+    m_thread = QThread::create([this, generation, graph, initial, options]() {
+        QVector<QPointF> positions;
+        if (options.algorithm == LayoutOptions::Layered) {
+            positions = NetLayout::layered(graph, options);
+        } else {
+            positions = NetLayout::forceDirected(graph, initial, options, [this, generation](const QVector<QPointF>& frame) {
+                // Кадр отправляется, только если предыдущий уже применён
+                if (!m_framePending.exchange(true))
+                    emit positionsUpdated(generation, frame);
+                return !m_cancelled;
+            });
+        }
+        emit layoutFinished(generation, positions, m_cancelled);
+    });
+    m_thread->start();
+    return generation;
+}
+
+void LayoutRunner::cancel()
+{
+    m_cancelled = true;
+}
+
+void LayoutRunner::frameApplied()
+{
+    m_framePending = false;
+}
@@ -0,0 +1,90 @@
+#ifndef NETLAYOUT_H
+#define NETLAYOUT_H
+
+#include <QObject>
+#include <QVector>
+#include <QPointF>
+#include <QThread>
+#include <atomic>
+#include <functional>
+
+#include "petrinetmodel.h"
+
+// Двудольный граф сети для раскладки: узлы 0..placeCount-1 — позиции,
+// далее переходы. Рёбра хранятся в CSR-форме (без учёта направления)
+// плюс исходный список дуг для послойной раскладки.
+struct LayoutGraph {
+    int placeCount{0};
+    int transitionCount{0};
+    QVector<int> nodeIds;           // id элемента модели для каждого узла
+    QVector<QPair<int, int>> edges; // направленные дуги source -> target
+    QVector<int> adjacencyStart;    // CSR: соседи узла v — adjacency[adjacencyStart[v] .. adjacencyStart[v + 1])
+    QVector<int> adjacency;
+
+    int nodeCount() const { return placeCount + transitionCount; }
+    bool isPlace(int node) const { return node < placeCount; }
+
+    static LayoutGraph fromModel(const PetriNetModel& model);
+    void buildAdjacency();
+};
+
+struct LayoutOptions {
+    enum Algorithm {
+        ForceDirected, // Barnes–Hut, силовая раскладка
+        Layered        // Послойная раскладка Сугиямы для сетей-процессов
+    };
+
+    Algorithm algorithm{ForceDirected};
+    int iterations{300};
+    double edgeLength{120.0};   // Желаемая длина дуги
+    double theta{0.8};          // Точность Barnes–Hut: больше — быстрее и грубее
+    double crossKindRepulsion{0.5}; // Отталкивание позиция–переход относительно однотипных узлов
+    double layerSpacing{160.0};
+    double nodeSpacing{100.0};
+    int threads{0};             // 0 — по числу ядер
+    int progressInterval{10};   // Итераций между промежуточными результатами
+};
+
+// Алгоритмы раскладки; progress вызывается из рабочего потока и может
+// вернуть false для отмены.
+namespace NetLayout {
+
+using Progress = std::function<bool(const QVector<QPointF>& positions)>;
+
+QVector<QPointF> forceDirected(const LayoutGraph& graph, const QVector<QPointF>& initial,
+                               const LayoutOptions& options, const Progress& progress = Progress());
+QVector<QPointF> layered(const LayoutGraph& graph, const LayoutOptions& options);
+
+}
+
+// Запускает раскладку в отдельном потоке и передаёт промежуточные позиции
+// в поток GUI. Пока предыдущий кадр не обработан, новые не отправляются.
+class LayoutRunner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LayoutRunner(QObject *parent = nullptr);
+    ~LayoutRunner();
+
+    bool isRunning() const;
+    // Номер последнего запуска; сигналы несут номер своего запуска,
+    // чтобы запоздавшие сигналы прежней раскладки можно было отбросить
+    quint64 generation() const { return m_generation; }
+    quint64 start(const LayoutGraph& graph, const QVector<QPointF>& initial, const LayoutOptions& options);
+    void cancel();
+
+    // Подтверждение того, что промежуточный кадр применён
+    void frameApplied();
+
+signals:
+    void positionsUpdated(quint64 generation, const QVector<QPointF>& positions);
+    void layoutFinished(quint64 generation, const QVector<QPointF>& positions, bool cancelled);
+
+private:
+    QThread* m_thread{nullptr};
+    quint64 m_generation{0};
+    std::atomic<bool> m_cancelled{false};
+    std::atomic<bool> m_framePending{false};
+};
+
+#endif // NETLAYOUT_H
@@ -0,0 +1,430 @@
+// petrinetmodel.cpp
+#include "petrinetmodel.h"
+#include "petriprofiler.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QFile>
+#include <QSaveFile>
+
+namespace {
+const int FormatVersion = 1;
+}
+
+QJsonObject PetriNetModel::placeToJson(const PlaceData &place)
+{
+    QJsonObject json;
+    json["id"] = place.id;
+    json["label"] = place.label;
+    json["x"] = place.pos.x();
+    json["y"] = place.pos.y();
+    json["tokens"] = place.tokens;
+    if (place.port)
+        json["port"] = true;
+    if (place.queue)
+        json["queue"] = true;
+    return json;
+}
+
+QJsonObject PetriNetModel::transitionToJson(const TransitionData &transition)
+{
+    QJsonObject json;
+    json["id"] = transition.id;
+    json["label"] = transition.label;
+    json["x"] = transition.pos.x();
+    json["y"] = transition.pos.y();
+    if (transition.subnet >= 0) {
+        QJsonArray ports;
+        for (auto it = transition.ports.cbegin(); it != transition.ports.cend(); ++it)
+            ports.append(QJsonObject{{"port", it.key()}, {"place", it.value()}});
+        json["subnet"] = transition.subnet;
+        json["ports"] = ports;
+    }
+    return json;
+}
+
+QJsonObject PetriNetModel::arcToJson(const ArcData &arc)
+{
+    QJsonObject json;
+    json["id"] = arc.id;
+    json["place"] = arc.place;
+    json["transition"] = arc.transition;
+    json["fromPlace"] = arc.fromPlace;
+    json["weight"] = arc.weight;
+    return json;
+}
+
+PlaceData PetriNetModel::placeFromJson(const QJsonObject &json)
+{
+    PlaceData place;
+    place.id = json["id"].toInt();
+    place.label = json["label"].toString();
+    place.pos = QPointF(json["x"].toDouble(), json["y"].toDouble());
+    place.tokens = json["tokens"].toInt();
+    place.port = json["port"].toBool();
+    place.queue = json["queue"].toBool();
+    return place;
+}
+
+TransitionData PetriNetModel::transitionFromJson(const QJsonObject &json)
+{
+    TransitionData transition;
+    transition.id = json["id"].toInt();
+    transition.label = json["label"].toString();
+    transition.pos = QPointF(json["x"].toDouble(), json["y"].toDouble());
+    transition.subnet = json["subnet"].toInt(-1);
+    for (const QJsonValue& value : json["ports"].toArray()) {
+        const QJsonObject binding = value.toObject();
+        transition.ports.insert(binding["port"].toInt(), binding["place"].toInt());
+    }
+    return transition;
+}
+
+ArcData PetriNetModel::arcFromJson(const QJsonObject &json)
+{
+    ArcData arc;
+    arc.id = json["id"].toInt();
+    arc.place = json["place"].toInt();
+    arc.transition = json["transition"].toInt();
+    arc.fromPlace = json["fromPlace"].toBool(true);
+    arc.weight = json["weight"].toInt(1);
+    return arc;
+}
+
+QJsonObject PetriNetModel::toJson() const
+{
+    QJsonArray placesJson;
+    for (const PlaceData& place : places)
+        placesJson.append(placeToJson(place));
+
+    QJsonArray transitionsJson;
+    for (const TransitionData& transition : transitions)
+        transitionsJson.append(transitionToJson(transition));
+
+    QJsonArray arcsJson;
+    for (const ArcData& arc : arcs)
+        arcsJson.append(arcToJson(arc));
+
+    QJsonObject json;
+    json["version"] = FormatVersion;
+    json["nextId"] = nextId;
+    json["places"] = placesJson;
+    json["transitions"] = transitionsJson;
+    json["arcs"] = arcsJson;
+
+    if (!subnets.isEmpty()) {
+        QJsonArray subnetsJson;
+        for (auto it = subnets.cbegin(); it != subnets.cend(); ++it) {
+            if (!it.value().net) continue;
+            subnetsJson.append(QJsonObject{{"id", it.key()}, {"name", it.value().name}, {"net", it.value().net->toJson()}});
+        }
+        json["subnets"] = subnetsJson;
+    }
+    return json;
+}
+
+bool PetriNetModel::fromJson(const QJsonObject &json, PetriNetModel *model, QString *error)
+{
+    if (json["version"].toInt() > FormatVersion) {
+        if (error) *error = "Unsupported file version";
+        return false;
+    }
+
+    PetriNetModel result;
+    for (const QJsonValue& value : json["places"].toArray())
+        result.places.append(placeFromJson(value.toObject()));
+    for (const QJsonValue& value : json["transitions"].toArray())
+        result.transitions.append(transitionFromJson(value.toObject()));
+    for (const QJsonValue& value : json["arcs"].toArray())
+        result.arcs.append(arcFromJson(value.toObject()));
+    result.rebuildIndex();
+
+    // Дуги должны ссылаться на существующие узлы
+    int maxId = -1;
+    for (const ArcData& arc : result.arcs) {
+        if (result.placeIndex(arc.place) < 0 || result.transitionIndex(arc.transition) < 0) {
+            if (error) *error = QString("Arc %1 references a missing node").arg(arc.id);
+            return false;
+        }
+        maxId = qMax(maxId, arc.id);
+    }
+    for (const PlaceData& place : result.places)
+        maxId = qMax(maxId, place.id);
+    for (const TransitionData& transition : result.transitions)
+        maxId = qMax(maxId, transition.id);
+    result.nextId = qMax(json["nextId"].toInt(), maxId + 1);
+
+    for (const QJsonValue& value : json["subnets"].toArray()) {
+        const QJsonObject pageJson = value.toObject();
+        SubnetPage page;
+        page.name = pageJson["name"].toString();
+        page.net = QSharedPointer<PetriNetModel>::create();
+        if (!fromJson(pageJson["net"].toObject(), page.net.data(), error))
+            return false;
+        result.subnets.insert(pageJson["id"].toInt(), page);
+    }
+
+    *model = result;
+    return true;
+}
+
+bool PetriNetModel::saveToFile(const QString &fileName, QString *error) const
+{
+    PETRI_PROFILE_SCOPE("model.save");
+    // QSaveFile пишет во временный файл и атомарно переименовывает его при commit()
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    const QByteArray data = QJsonDocument(toJson()).toJson(QJsonDocument::Compact);
+    file.write(data);
+    PETRI_PROFILE_COUNT("model.saveBytes", data.size());
+    if (!file.commit()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool PetriNetModel::loadFromFile(const QString &fileName, PetriNetModel *model, QString *error)
+{
+    PETRI_PROFILE_SCOPE("model.load");
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+
+    const QByteArray data = file.readAll();
+    PETRI_PROFILE_COUNT("model.loadBytes", data.size());
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
+    if (doc.isNull()) {
+        if (error) *error = parseError.errorString();
+        return false;
+    }
+    return fromJson(doc.object(), model, error);
+}
+
+bool PetriNetModel::applyChange(const QJsonObject &change)
+{
+    // Запись относится к странице подсети
+    if (change.contains("page")) {
+        const int page = change["page"].toInt();
+        if (!subnets.contains(page) || !subnets[page].net)
+            return false;
+        QJsonObject pageChange = change;
+        pageChange.remove("page");
+        return subnets[page].net->applyChange(pageChange);
+    }
+
+    const QString op = change["op"].toString();
+    const int id = change["id"].toInt();
+
+    if (op == "addPlace") {
+        if (placeIndex(id) >= 0) return false;
+        m_placeIndex.insert(id, places.size());
+        places.append(placeFromJson(change));
+    }
+    else if (op == "addTransition") {
+        if (transitionIndex(id) >= 0) return false;
+        m_transitionIndex.insert(id, transitions.size());
+        transitions.append(transitionFromJson(change));
+    }
+    else if (op == "addArc") {
+        ArcData arc = arcFromJson(change);
+        if (arcIndex(id) >= 0 || placeIndex(arc.place) < 0 || transitionIndex(arc.transition) < 0)
+            return false;
+        m_arcIndex.insert(id, arcs.size());
+        arcs.append(arc);
+    }
+    else if (op == "remove") {
+        if (arcIndex(id) >= 0)
+            removeArc(id);
+        else if (placeIndex(id) >= 0)
+            removePlace(id);
+        else if (transitionIndex(id) >= 0)
+            removeTransition(id);
+        else
+            return false;
+    }
+    else if (op == "move") {
+        QPointF pos(change["x"].toDouble(), change["y"].toDouble());
+        if (placeIndex(id) >= 0)
+            places[placeIndex(id)].pos = pos;
+        else if (transitionIndex(id) >= 0)
+            transitions[transitionIndex(id)].pos = pos;
+        else
+            return false;
+    }
+    else if (op == "tokens") {
+        if (placeIndex(id) < 0) return false;
+        places[placeIndex(id)].tokens = change["value"].toInt();
+    }
+    else if (op == "queue") {
+        if (placeIndex(id) < 0) return false;
+        places[placeIndex(id)].queue = change["value"].toBool();
+    }
+    else if (op == "weight") {
+        if (arcIndex(id) < 0) return false;
+        arcs[arcIndex(id)].weight = change["value"].toInt();
+    }
+    else if (op == "subnet") {
+        if (transitionIndex(id) < 0) return false;
+        const TransitionData data = transitionFromJson(change);
+        TransitionData& transition = transitions[transitionIndex(id)];
+        transition.subnet = data.subnet;
+        transition.ports = data.ports;
+    }
+    else {
+        return false;
+    }
+
+    nextId = qMax(nextId, id + 1);
+    return true;
+}
+
+void PetriNetModel::detachSubnets()
+{
+    for (auto it = subnets.begin(); it != subnets.end(); ++it) {
+        if (it.value().net)
+            it.value().net = QSharedPointer<PetriNetModel>::create(*it.value().net);
+    }
+}
+
+PetriNetModel PetriNetModel::flattened(QString *error) const
+{
+    PETRI_PROFILE_SCOPE("model.flatten");
+    PetriNetModel flat;
+    QSet<int> active;
+    if (!flattenPage(*this, QString(), QHash<int, int>(), &flat, &active, error))
+        return PetriNetModel();
+    flat.rebuildIndex();
+    return flat;
+}
+
+bool PetriNetModel::flattenPage(const PetriNetModel &page, const QString &prefix, const QHash<int, int> &fusion,
+                                PetriNetModel *flat, QSet<int> *active, QString *error) const
+{
+    // id элементов страницы -> id элементов плоской сети
+    QHash<int, int> placeMap = fusion;
+    QHash<int, int> transitionMap;
+
+    for (const PlaceData& place : page.places) {
+        // Привязанный порт сливается с внешней позицией
+        if (placeMap.contains(place.id))
+            continue;
+        PlaceData flatPlace = place;
+        flatPlace.id = flat->nextId++;
+        flatPlace.label = prefix + place.label;
+        flatPlace.port = false;
+        placeMap.insert(place.id, flatPlace.id);
+        flat->places.append(flatPlace);
+    }
+
+    for (const TransitionData& transition : page.transitions) {
+        if (transition.subnet < 0) {
+            TransitionData flatTransition = transition;
+            flatTransition.id = flat->nextId++;
+            flatTransition.label = prefix + transition.label;
+            transitionMap.insert(transition.id, flatTransition.id);
+            flat->transitions.append(flatTransition);
+            continue;
+        }
+
+        const SubnetPage subnet = subnets.value(transition.subnet);
+        if (!subnet.net) {
+            if (error) *error = QString("Transition %1 references a missing subnet").arg(prefix + transition.label);
+            return false;
+        }
+        if (active->contains(transition.subnet)) {
+            if (error) *error = QString("Subnet %1 contains itself").arg(subnet.name);
+            return false;
+        }
+
+        QHash<int, int> innerFusion;
+        for (auto it = transition.ports.cbegin(); it != transition.ports.cend(); ++it) {
+            if (placeMap.contains(it.value()))
+                innerFusion.insert(it.key(), placeMap.value(it.value()));
+        }
+
+        active->insert(transition.subnet);
+        if (!flattenPage(*subnet.net, prefix + transition.label + "/", innerFusion, flat, active, error))
+            return false;
+        active->remove(transition.subnet);
+    }
+
+    // Дуги перехода-подстановки заменены слиянием портов
+    for (const ArcData& arc : page.arcs) {
+        if (!transitionMap.contains(arc.transition) || !placeMap.contains(arc.place))
+            continue;
+        ArcData flatArc = arc;
+        flatArc.id = flat->nextId++;
+        flatArc.place = placeMap.value(arc.place);
+        flatArc.transition = transitionMap.value(arc.transition);
+        flat->arcs.append(flatArc);
+    }
+    return true;
+}
+
+int PetriNetModel::placeIndex(int id) const
+{
+    return m_placeIndex.value(id, -1);
+}
+
+int PetriNetModel::transitionIndex(int id) const
+{
+    return m_transitionIndex.value(id, -1);
+}
+
+int PetriNetModel::arcIndex(int id) const
+{
+    return m_arcIndex.value(id, -1);
+}
+
+void PetriNetModel::rebuildIndex()
+{
+    m_placeIndex.clear();
+    m_transitionIndex.clear();
+    m_arcIndex.clear();
+    for (int i = 0; i < places.size(); ++i)
+        m_placeIndex.insert(places[i].id, i);
+    for (int i = 0; i < transitions.size(); ++i)
+        m_transitionIndex.insert(transitions[i].id, i);
+    for (int i = 0; i < arcs.size(); ++i)
+        m_arcIndex.insert(arcs[i].id, i);
+}
+
+// Удаление перестановкой с последним элементом: O(1) с поддержкой индекса.
+// Инцидентные дуги журнал удаляет отдельными записями раньше узла.
+
+void PetriNetModel::removePlace(int id)
+{
+    int index = m_placeIndex.take(id);
+    if (index != places.size() - 1) {
+        places[index] = places.last();
+        m_placeIndex[places[index].id] = index;
+    }
+    places.removeLast();
+}
+
+void PetriNetModel::removeTransition(int id)
+{
+    int index = m_transitionIndex.take(id);
+    if (index != transitions.size() - 1) {
+        transitions[index] = transitions.last();
+        m_transitionIndex[transitions[index].id] = index;
+    }
+    transitions.removeLast();
+}
+
+void PetriNetModel::removeArc(int id)
+{
+    int index = m_arcIndex.take(id);
+    if (index != arcs.size() - 1) {
+        arcs[index] = arcs.last();
+        m_arcIndex[arcs[index].id] = index;
+    }
+    arcs.removeLast();
+}
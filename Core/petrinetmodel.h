@@ -0,0 +1,105 @@
+#ifndef PETRINETMODEL_H
+#define PETRINETMODEL_H
+
+#include <QString>
+#include <QPointF>
+#include <QVector>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QSharedPointer>
+#include <QJsonObject>
+
+// Описание сети без графических элементов: снимок сцены для сохранения,
+// автосохранения и движков анализа. Используется только QtCore.
+
+struct PlaceData {
+    int id{0};
+    QString label;
+    QPointF pos;
+    int tokens{0};
+    bool port{false};   // Порт страницы подсети
+    bool queue{false};  // Фишки — записи, извлекаемые в порядке FIFO
+};
+
+struct TransitionData {
+    int id{0};
+    QString label;
+    QPointF pos;
+    int subnet{-1};         // Страница подсети для перехода-подстановки
+    QHash<int, int> ports;  // id порта страницы -> id позиции этой сети
+};
+
+struct ArcData {
+    int id{0};
+    int place{0};       // id позиции
+    int transition{0};  // id перехода
+    bool fromPlace{true};
+    int weight{1};
+};
+
+class PetriNetModel;
+
+// Страница подсети хранится один раз; переходы-подстановки ссылаются на неё
+// по id. Разделяемые страницы не изменяются: правка создаёт новую копию.
+struct SubnetPage {
+    QString name;
+    QSharedPointer<PetriNetModel> net;
+};
+
+class PetriNetModel
+{
+public:
+    QVector<PlaceData> places;
+    QVector<TransitionData> transitions;
+    QVector<ArcData> arcs;
+
+    // Страницы подсетей документа (задаются только у корневой сети)
+    QMap<int, SubnetPage> subnets;
+
+    // Следующий свободный идентификатор элемента
+    int nextId{0};
+
+    QJsonObject toJson() const;
+    static bool fromJson(const QJsonObject& json, PetriNetModel* model, QString* error = nullptr);
+
+    bool saveToFile(const QString& fileName, QString* error = nullptr) const;
+    static bool loadFromFile(const QString& fileName, PetriNetModel* model, QString* error = nullptr);
+
+    static QJsonObject placeToJson(const PlaceData& place);
+    static QJsonObject transitionToJson(const TransitionData& transition);
+    static QJsonObject arcToJson(const ArcData& arc);
+    static PlaceData placeFromJson(const QJsonObject& json);
+    static TransitionData transitionFromJson(const QJsonObject& json);
+    static ArcData arcFromJson(const QJsonObject& json);
+
+    // Применение записи журнала изменений (см. PetriNetScene::netChanged).
+    // Записи страниц подсетей изменяют страницы на месте — перед этим
+    // вызывающий должен получить собственные копии через detachSubnets().
+    bool applyChange(const QJsonObject& change);
+    void detachSubnets();
+
+    // Плоская сеть: экземпляры подсетей раскрыты, порты слиты с позициями,
+    // к которым привязаны. Метки элементов получают префикс пути экземпляра.
+    PetriNetModel flattened(QString* error = nullptr) const;
+
+    int placeIndex(int id) const;
+    int transitionIndex(int id) const;
+    int arcIndex(int id) const;
+
+    void rebuildIndex();
+
+private:
+    bool flattenPage(const PetriNetModel& page, const QString& prefix, const QHash<int, int>& fusion,
+                     PetriNetModel* flat, QSet<int>* active, QString* error) const;
+
+    void removePlace(int id);
+    void removeTransition(int id);
+    void removeArc(int id);
+
+    QHash<int, int> m_placeIndex;
+    QHash<int, int> m_transitionIndex;
+    QHash<int, int> m_arcIndex;
+};
+
+#endif // PETRINETMODEL_H
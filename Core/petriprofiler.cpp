@@ -0,0 +1,278 @@
+// petriprofiler.cpp
+#include "petriprofiler.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+std::atomic<bool> PetriProfiler::s_enabled{true};
+std::atomic<bool> PetriProfiler::s_tracing{false};
+
+namespace {
+
+struct TraceEvent {
+    int site;
+    qint64 start;
+    qint64 duration;
+};
+
+// Буфер потока: пишет только владелец, читают снимок и экспорт.
+// Для однописательских атомиков достаточно relaxed load + store.
+struct ThreadBuffer {
+    int tid{0};
+    QString name;
+    std::atomic<qint64> calls[PetriProfiler::MaxSites]{};
+    std::atomic<qint64> nanos[PetriProfiler::MaxSites]{};
+    std::atomic<qint64> maxNanos[PetriProfiler::MaxSites]{};
+
+    QMutex eventMutex; // Без конкуренции, пока не идёт экспорт
+    std::vector<TraceEvent> events;
+    qint64 droppedEvents{0};
+};
+
+const size_t MaxEventsPerThread = 1 << 20;
+
+struct Registry {
+    QMutex mutex;
+    std::vector<const char*> names;
+    std::vector<std::unique_ptr<ThreadBuffer>> threads;
+    qint64 traceStart{0};
+};
+
+Registry& registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+// Буферы живут до конца программы, чтобы данные завершившихся
+// потоков (например, пула QtConcurrent) попадали в снимок
+ThreadBuffer* threadBuffer()
+{
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        Registry& r = registry();
+        QMutexLocker locker(&r.mutex);
+        auto owned = std::make_unique<ThreadBuffer>();
+        owned->tid = int(r.threads.size()) + 1;
+        QThread* thread = QThread::currentThread();
+        owned->name = thread ? thread->objectName() : QString();
+        if (owned->name.isEmpty())
+            owned->name = owned->tid == 1 ? QString("main") : QString("thread %1").arg(owned->tid);
+        buffer = owned.get();
+        r.threads.push_back(std::move(owned));
+    }
+    return buffer;
+}
+
+void add(std::atomic<qint64>& value, qint64 delta)
+{
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+// Строка JSON: кавычка, обратная косая черта и управляющие символы
+// (ниже U+0020) экранируются, иначе трассу не прочитает ни один просмотрщик
+QByteArray jsonString(const QString& text)
+{
+    static const char hex[] = "0123456789abcdef";
+    const QByteArray utf8 = text.toUtf8();
+    QByteArray escaped;
+    escaped.reserve(utf8.size() + 2);
+    escaped += '"';
+    for (char c : utf8) {
+        const uchar byte = uchar(c);
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (byte < 0x20) {
+            escaped += "\\u00";
+            escaped += hex[byte >> 4];
+            escaped += hex[byte & 0xf];
+        } else {
+            escaped += c;
+        }
+    }
+    escaped += '"';
+    return escaped;
+}
+
+}
+
+PetriProfiler::Site::Site(const char *name)
+{
+    // Одноимённые точки из разных единиц трансляции сливаются
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+    for (size_t i = 0; i < r.names.size(); ++i) {
+        if (std::strcmp(r.names[i], name) == 0) {
+            m_index = int(i);
+            return;
+        }
+    }
+    if (r.names.size() >= size_t(MaxSites)) {
+        m_index = -1;
+        return;
+    }
+    m_index = int(r.names.size());
+    r.names.push_back(name);
+}
+
+void PetriProfiler::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void PetriProfiler::setTracing(bool tracing)
+{
+    if (tracing && !isTracing()) {
+        Registry& r = registry();
+        QMutexLocker locker(&r.mutex);
+        if (r.traceStart == 0)
+            r.traceStart = now();
+    }
+    s_tracing.store(tracing, std::memory_order_relaxed);
+}
+
+bool PetriProfiler::isCompiledIn()
+{
+#ifdef PETRI_PROFILING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void PetriProfiler::count(const Site &site, qint64 value)
+{
+    if (site.index() < 0 || !isEnabled())
+        return;
+    add(threadBuffer()->calls[site.index()], value);
+}
+
+void PetriProfiler::finish(int site, qint64 start, qint64 end)
+{
+    if (site < 0)
+        return;
+    ThreadBuffer* buffer = threadBuffer();
+    const qint64 duration = end - start;
+    add(buffer->calls[site], 1);
+    add(buffer->nanos[site], duration);
+    if (duration > buffer->maxNanos[site].load(std::memory_order_relaxed))
+        buffer->maxNanos[site].store(duration, std::memory_order_relaxed);
+
+    if (isTracing()) {
+        QMutexLocker locker(&buffer->eventMutex);
+        if (buffer->events.size() < MaxEventsPerThread)
+            buffer->events.push_back({site, start, duration});
+        else
+            buffer->droppedEvents++;
+    }
+}
+
+QVector<PetriProfiler::SiteStats> PetriProfiler::snapshot()
+{
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+
+    QVector<SiteStats> stats(int(r.names.size()));
+    for (int i = 0; i < stats.size(); ++i)
+        stats[i].name = QString::fromUtf8(r.names[size_t(i)]);
+
+    for (const auto& buffer : r.threads) {
+        for (int i = 0; i < stats.size(); ++i) {
+            stats[i].calls += buffer->calls[i].load(std::memory_order_relaxed);
+            stats[i].nanos += buffer->nanos[i].load(std::memory_order_relaxed);
+            stats[i].maxNanos = qMax(stats[i].maxNanos, buffer->maxNanos[i].load(std::memory_order_relaxed));
+        }
+    }
+    return stats;
+}
+
+void PetriProfiler::reset()
+{
+    // Запись, идущая одновременно со сбросом, может пережить его —
+    // для статистики это допустимо
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+    for (const auto& buffer : r.threads) {
+        for (int i = 0; i < MaxSites; ++i) {
+            buffer->calls[i].store(0, std::memory_order_relaxed);
+            buffer->nanos[i].store(0, std::memory_order_relaxed);
+            buffer->maxNanos[i].store(0, std::memory_order_relaxed);
+        }
+        QMutexLocker eventLocker(&buffer->eventMutex);
+        buffer->events.clear();
+        buffer->droppedEvents = 0;
+    }
+    r.traceStart = isTracing() ? now() : 0;
+}
+
+qint64 PetriProfiler::traceEventCount()
+{
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+    qint64 total = 0;
+    for (const auto& buffer : r.threads) {
+        QMutexLocker eventLocker(&buffer->eventMutex);
+        total += qint64(buffer->events.size());
+    }
+    return total;
+}
+
+bool PetriProfiler::exportChromeTrace(const QString &fileName, QString *error)
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+
+    // Событие "X" — завершённая область; время в микросекундах
+    QByteArray chunk;
+    chunk += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&]() {
+        if (!first) chunk += ",\n";
+        first = false;
+    };
+
+    for (const auto& buffer : r.threads) {
+        separator();
+        chunk += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + QByteArray::number(buffer->tid)
+                 + ",\"args\":{\"name\":" + jsonString(buffer->name) + "}}";
+
+        QMutexLocker eventLocker(&buffer->eventMutex);
+        for (const TraceEvent& event : buffer->events) {
+            separator();
+            chunk += "{\"name\":" + jsonString(QString::fromUtf8(r.names[size_t(event.site)]))
+                     + ",\"cat\":\"petri\",\"ph\":\"X\",\"pid\":1,\"tid\":" + QByteArray::number(buffer->tid)
+                     + ",\"ts\":" + QByteArray::number((event.start - r.traceStart) / 1000.0, 'f', 3)
+                     + ",\"dur\":" + QByteArray::number(event.duration / 1000.0, 'f', 3) + "}";
+            if (chunk.size() > (1 << 20)) {
+                file.write(chunk);
+                chunk.clear();
+            }
+        }
+        if (buffer->droppedEvents > 0) {
+            separator();
+            chunk += "{\"name\":\"dropped events\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":"
+                     + QByteArray::number(buffer->tid) + ",\"ts\":0,\"args\":{\"count\":"
+                     + QByteArray::number(buffer->droppedEvents) + "}}";
+        }
+    }
+    chunk += "\n]}\n";
+    file.write(chunk);
+
+    if (!file.commit()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
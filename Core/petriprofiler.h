@@ -0,0 +1,109 @@
+#ifndef PETRIPROFILER_H
+#define PETRIPROFILER_H
+
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <chrono>
+
+// Инструментирование горячих путей: счётчики и замеры областей.
+// Макросы раскрываются в код только при сборке с PETRI_PROFILING
+// (qmake CONFIG+=profiling), иначе они пустые.
+//
+// Каждая точка замера регистрируется один раз (статическая Site) и получает
+// номер; потоки пишут в собственные буферы без блокировок, поэтому запись
+// стоит два чтения часов и две записи в память потока.
+
+#ifdef PETRI_PROFILING
+#define PETRI_PROFILE_CONCAT_(a, b) a##b
+#define PETRI_PROFILE_CONCAT(a, b) PETRI_PROFILE_CONCAT_(a, b)
+#define PETRI_PROFILE_SCOPE(name) \
+    static const PetriProfiler::Site PETRI_PROFILE_CONCAT(petriProfileSite, __LINE__)(name); \
+    const PetriProfiler::Scope PETRI_PROFILE_CONCAT(petriProfileScope, __LINE__)(PETRI_PROFILE_CONCAT(petriProfileSite, __LINE__))
+#define PETRI_PROFILE_COUNT(name, value) \
+    do { \
+        static const PetriProfiler::Site petriProfileSite(name); \
+        PetriProfiler::count(petriProfileSite, value); \
+    } while (false)
+#else
+#define PETRI_PROFILE_SCOPE(name) do {} while (false)
+#define PETRI_PROFILE_COUNT(name, value) do {} while (false)
+#endif
+
+class PetriProfiler
+{
+public:
+    static const int MaxSites = 256;
+
+    // Точка замера: имя должно быть строковым литералом
+    class Site
+    {
+    public:
+        explicit Site(const char* name);
+        int index() const { return m_index; }
+
+    private:
+        int m_index;
+    };
+
+    class Scope
+    {
+    public:
+        explicit Scope(const Site& site)
+            : m_site(site.index()),
+            m_start(isEnabled() ? now() : -1)
+        {
+        }
+        ~Scope()
+        {
+            if (m_start >= 0)
+                finish(m_site, m_start, now());
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        int m_site;
+        qint64 m_start;
+    };
+
+    struct SiteStats {
+        QString name;
+        qint64 calls{0};    // Число входов в область или сумма счётчика
+        qint64 nanos{0};    // Суммарное время области (0 для счётчиков)
+        qint64 maxNanos{0};
+    };
+
+    // Замеры можно выключить во время работы; трассировка событий
+    // включается отдельно, так как хранит каждое событие
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+    static bool isTracing() { return s_tracing.load(std::memory_order_relaxed); }
+    static void setTracing(bool tracing);
+    static bool isCompiledIn();
+
+    static void count(const Site& site, qint64 value);
+
+    // Суммы по всем потокам; порядок — по регистрации точек
+    static QVector<SiteStats> snapshot();
+    static void reset();
+
+    // Трассировка в формате Chrome trace events (chrome://tracing, Perfetto)
+    static bool exportChromeTrace(const QString& fileName, QString* error = nullptr);
+    static qint64 traceEventCount();
+
+    static qint64 now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    static void finish(int site, qint64 start, qint64 end);
+
+    static std::atomic<bool> s_enabled;
+    static std::atomic<bool> s_tracing;
+};
+
+#endif // PETRIPROFILER_H
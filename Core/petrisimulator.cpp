@@ -0,0 +1,155 @@
+// petrisimulator.cpp
+#include "petrisimulator.h"
+#include "petriprofiler.h"
+
+#include <QHash>
+#include <QSet>
+
+CompiledNet CompiledNet::fromModel(const PetriNetModel &model, QString *error)
+{
+    PETRI_PROFILE_SCOPE("net.compile");
+    QString flattenError;
+    const PetriNetModel flat = model.subnets.isEmpty() ? model : model.flattened(&flattenError);
+    if (!flattenError.isEmpty()) {
+        if (error)
+            *error = flattenError;
+        else
+            qWarning("CompiledNet::fromModel: %s", qPrintable(flattenError));
+        return CompiledNet();
+    }
+
+    CompiledNet net;
+    QHash<int, int> placeIndex;
+    QHash<int, int> transitionIndex;
+    for (const PlaceData& place : flat.places) {
+        placeIndex.insert(place.id, net.placeIds.size());
+        net.placeIds.append(place.id);
+        net.placeLabels.append(place.label);
+        net.initialMarking.append(place.tokens);
+        net.queuePlaces.append(place.queue);
+    }
+    for (const TransitionData& transition : flat.transitions) {
+        transitionIndex.insert(transition.id, net.transitionIds.size());
+        net.transitionIds.append(transition.id);
+        net.transitionLabels.append(transition.label);
+    }
+
+    const int transitionCount = net.transitionIds.size();
+    QVector<QVector<Arc>> inputs(transitionCount);
+    QVector<QVector<Arc>> outputs(transitionCount);
+    for (const ArcData& arc : flat.arcs) {
+        const int place = placeIndex.value(arc.place, -1);
+        const int transition = transitionIndex.value(arc.transition, -1);
+        if (place < 0 || transition < 0) continue;
+        (arc.fromPlace ? inputs : outputs)[transition].append({place, arc.weight});
+    }
+
+    // Потребители позиции: переходы, у которых она во входах
+    QVector<QVector<int>> consumers(net.placeIds.size());
+    for (int t = 0; t < transitionCount; ++t) {
+        for (const Arc& arc : inputs[t])
+            consumers[arc.place].append(t);
+    }
+
+    net.inputStart.append(0);
+    net.outputStart.append(0);
+    net.affectedStart.append(0);
+    for (int t = 0; t < transitionCount; ++t) {
+        net.inputs += inputs[t];
+        net.outputs += outputs[t];
+        net.inputStart.append(net.inputs.size());
+        net.outputStart.append(net.outputs.size());
+
+        QSet<int> affected;
+        for (const Arc& arc : inputs[t]) {
+            for (int u : consumers[arc.place])
+                affected.insert(u);
+        }
+        for (const Arc& arc : outputs[t]) {
+            for (int u : consumers[arc.place])
+                affected.insert(u);
+        }
+        for (int u : affected)
+            net.affected.append(u);
+        net.affectedStart.append(net.affected.size());
+    }
+    return net;
+}
+
+bool CompiledNet::isEnabled(const int *marking, int transition) const
+{
+    for (int i = inputStart[transition]; i < inputStart[transition + 1]; ++i) {
+        if (marking[inputs[i].place] < inputs[i].weight)
+            return false;
+    }
+    return true;
+}
+
+void CompiledNet::fire(int *marking, int transition) const
+{
+    for (int i = inputStart[transition]; i < inputStart[transition + 1]; ++i)
+        marking[inputs[i].place] -= inputs[i].weight;
+    for (int i = outputStart[transition]; i < outputStart[transition + 1]; ++i)
+        marking[outputs[i].place] += outputs[i].weight;
+}
+
+PetriSimulator::PetriSimulator(const CompiledNet &net, quint32 seed)
+    : m_net(net),
+    m_random(seed)
+{
+    reset();
+}
+
+void PetriSimulator::reset()
+{
+    m_marking = m_net.initialMarking;
+    m_firingCounts.fill(0, m_net.transitionCount());
+    m_lastFired = -1;
+    m_enabled.clear();
+    m_enabledPosition.fill(-1, m_net.transitionCount());
+    for (int t = 0; t < m_net.transitionCount(); ++t)
+        updateEnabled(t);
+}
+
+bool PetriSimulator::step()
+{
+    if (m_enabled.isEmpty())
+        return false;
+
+    const int transition = m_enabled[int(m_random.bounded(quint32(m_enabled.size())))];
+    m_net.fire(m_marking.data(), transition);
+    m_firingCounts[transition]++;
+    m_lastFired = transition;
+
+    for (int i = m_net.affectedStart[transition]; i < m_net.affectedStart[transition + 1]; ++i)
+        updateEnabled(m_net.affected[i]);
+    return true;
+}
+
+qint64 PetriSimulator::run(qint64 maxSteps)
+{
+    // Отдельное срабатывание слишком коротко для замера — считаем пакетом
+    PETRI_PROFILE_SCOPE("simulator.run");
+    qint64 fired = 0;
+    while (fired < maxSteps && step())
+        fired++;
+    PETRI_PROFILE_COUNT("simulator.firings", fired);
+    return fired;
+}
+
+void PetriSimulator::updateEnabled(int transition)
+{
+    const bool enabled = m_net.isEnabled(m_marking.constData(), transition);
+    const int position = m_enabledPosition[transition];
+    if (enabled && position < 0) {
+        m_enabledPosition[transition] = m_enabled.size();
+        m_enabled.append(transition);
+    } else if (!enabled && position >= 0) {
+        const int last = m_enabled.takeLast();
+        if (last != transition) {
+            m_enabled[position] = last;
+            m_enabledPosition[last] = position;
+        }
+        m_enabledPosition[transition] = -1;
+    }
+}
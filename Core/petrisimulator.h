@@ -0,0 +1,84 @@
+#ifndef PETRISIMULATOR_H
+#define PETRISIMULATOR_H
+
+#include <QVector>
+#include <QStringList>
+#include <QRandomGenerator>
+
+#include "petrinetmodel.h"
+
+// Сеть в компактной форме для движков: позиции и переходы пронумерованы
+// подряд, входы и выходы переходов хранятся в CSR-массивах.
+class CompiledNet
+{
+public:
+    struct Arc {
+        int place;
+        int weight;
+    };
+
+    // Иерархическая модель предварительно раскрывается (flattened()).
+    // При ошибке раскрытия возвращается пустая сеть, текст — в error
+    // (без error — в qWarning), чтобы ошибку не приняли за модель
+    static CompiledNet fromModel(const PetriNetModel& model, QString* error = nullptr);
+
+    int placeCount() const { return placeIds.size(); }
+    int transitionCount() const { return transitionIds.size(); }
+
+    bool isEnabled(const int* marking, int transition) const;
+    void fire(int* marking, int transition) const;
+
+    bool hasQueues() const { return queuePlaces.contains(true); }
+
+    QVector<int> initialMarking;
+    QVector<bool> queuePlaces;  // Позиции-очереди (PlaceData::queue)
+
+    QVector<int> placeIds;
+    QVector<int> transitionIds;
+    QStringList placeLabels;
+    QStringList transitionLabels;
+
+    // Входы перехода t: inputs[inputStart[t] .. inputStart[t + 1])
+    QVector<int> inputStart;
+    QVector<Arc> inputs;
+    QVector<int> outputStart;
+    QVector<Arc> outputs;
+
+    // Переходы, разрешённость которых может измениться после срабатывания t
+    QVector<int> affectedStart;
+    QVector<int> affected;
+};
+
+// Случайное моделирование: на каждом шаге срабатывает равновероятно
+// выбранный разрешённый переход. Множество разрешённых переходов
+// обновляется инкрементально — только для затронутых переходов.
+class PetriSimulator
+{
+public:
+    explicit PetriSimulator(const CompiledNet& net, quint32 seed = 1);
+
+    void reset();
+    bool step();
+    // Возвращает число срабатываний; останавливается в тупике
+    qint64 run(qint64 maxSteps);
+
+    const QVector<int>& marking() const { return m_marking; }
+    const QVector<qint64>& firingCounts() const { return m_firingCounts; }
+    bool isDeadlocked() const { return m_enabled.isEmpty(); }
+    int enabledCount() const { return m_enabled.size(); }
+    // Переход, сработавший на последнем шаге, или -1
+    int lastFired() const { return m_lastFired; }
+
+private:
+    void updateEnabled(int transition);
+
+    CompiledNet m_net;
+    QRandomGenerator m_random;
+    QVector<int> m_marking;
+    QVector<int> m_enabled;         // Разрешённые переходы
+    QVector<int> m_enabledPosition; // Индекс в m_enabled или -1
+    QVector<qint64> m_firingCounts;
+    int m_lastFired{-1};
+};
+
+#endif // PETRISIMULATOR_H
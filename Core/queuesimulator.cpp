@@ -0,0 +1,139 @@
+// queuesimulator.cpp
+#include "queuesimulator.h"
+#include "petriprofiler.h"
+
+#include <cmath>
+
+QueueSimulator::QueueSimulator(const CompiledNet &net, quint32 seed)
+    : m_net(net),
+    m_simulator(net, seed),
+    m_random(seed ^ 0x9e3779b9u)
+{
+    m_queueOf.fill(-1, net.placeCount());
+    for (int p = 0; p < net.placeCount(); ++p) {
+        if (net.queuePlaces[p]) {
+            m_queueOf[p] = m_queuePlaces.size();
+            m_queuePlaces.append(p);
+            m_queues.emplace_back(&m_pool);
+        }
+    }
+    reset();
+}
+
+void QueueSimulator::reset()
+{
+    m_simulator.reset();
+    m_time = 0;
+    m_nextTokenId = 0;
+    m_stats.fill(QueueStats(), m_queuePlaces.size());
+    m_lastChange.fill(0, m_queuePlaces.size());
+
+    // Начальные фишки появляются в момент 0; атрибут — позиция появления
+    for (int q = 0; q < m_queuePlaces.size(); ++q) {
+        const int place = m_queuePlaces[q];
+        m_queues[size_t(q)].clear();
+        for (int i = 0; i < m_net.initialMarking[place]; ++i) {
+            QueueToken token;
+            token.id = m_nextTokenId++;
+            token.attribute = quint32(place);
+            m_queues[size_t(q)].push(token);
+        }
+        m_stats[q].length = m_net.initialMarking[place];
+        m_stats[q].maxLength = m_stats[q].length;
+    }
+}
+
+void QueueSimulator::accumulate(int queue)
+{
+    QueueStats& stats = m_stats[queue];
+    stats.lengthArea += stats.length * (m_time - m_lastChange[queue]);
+    m_lastChange[queue] = m_time;
+}
+
+bool QueueSimulator::step()
+{
+    const int enabled = m_simulator.enabledCount();
+    if (enabled == 0)
+        return false;
+
+    // Минимум из enabled экспоненциальных задержек с интенсивностью 1
+    m_time += -std::log(1.0 - m_random.generateDouble()) / enabled;
+    m_simulator.step();
+    const int transition = m_simulator.lastFired();
+
+    QueueToken carrier;
+    bool hasCarrier = false;
+    for (int i = m_net.inputStart[transition]; i < m_net.inputStart[transition + 1]; ++i) {
+        const int queue = m_queueOf[m_net.inputs[i].place];
+        if (queue < 0) continue;
+        accumulate(queue);
+        QueueStats& stats = m_stats[queue];
+        for (int k = 0; k < m_net.inputs[i].weight; ++k) {
+            const QueueToken token = m_queues[size_t(queue)].pop();
+            const double wait = m_time - token.enqueued;
+            stats.totalWait += wait;
+            stats.maxWait = qMax(stats.maxWait, wait);
+            stats.departures++;
+            if (!hasCarrier) {
+                carrier = token;
+                hasCarrier = true;
+            }
+        }
+        stats.length -= m_net.inputs[i].weight;
+    }
+
+    for (int i = m_net.outputStart[transition]; i < m_net.outputStart[transition + 1]; ++i) {
+        const int place = m_net.outputs[i].place;
+        const int queue = m_queueOf[place];
+        if (queue < 0) continue;
+        accumulate(queue);
+        QueueStats& stats = m_stats[queue];
+        for (int k = 0; k < m_net.outputs[i].weight; ++k) {
+            QueueToken token = carrier;
+            if (!hasCarrier) {
+                token.created = m_time;
+                token.id = m_nextTokenId++;
+                token.attribute = quint32(place);
+            }
+            token.enqueued = m_time;
+            m_queues[size_t(queue)].push(token);
+        }
+        stats.arrivals += m_net.outputs[i].weight;
+        stats.length += m_net.outputs[i].weight;
+        stats.maxLength = qMax(stats.maxLength, stats.length);
+    }
+    return true;
+}
+
+qint64 QueueSimulator::run(qint64 maxSteps, double maxTime)
+{
+    PETRI_PROFILE_SCOPE("queues.run");
+    qint64 fired = 0;
+    while (fired < maxSteps && (maxTime <= 0 || m_time < maxTime) && step())
+        fired++;
+    PETRI_PROFILE_COUNT("queues.firings", fired);
+    return fired;
+}
+
+QueueStats QueueSimulator::stats(int place) const
+{
+    const int queue = m_queueOf.value(place, -1);
+    if (queue < 0)
+        return QueueStats();
+    QueueStats stats = m_stats[queue];
+    stats.lengthArea += stats.length * (m_time - m_lastChange[queue]);
+    return stats;
+}
+
+const QueueToken &QueueSimulator::front(int place) const
+{
+    return m_queues[size_t(m_queueOf[place])].front();
+}
+
+qint64 QueueSimulator::liveTokens() const
+{
+    qint64 total = 0;
+    for (const TokenQueue& queue : m_queues)
+        total += queue.size();
+    return total;
+}
@@ -0,0 +1,75 @@
+#ifndef QUEUESIMULATOR_H
+#define QUEUESIMULATOR_H
+
+#include <QVector>
+#include <QRandomGenerator>
+#include <vector>
+
+#include "petrisimulator.h"
+#include "tokenqueue.h"
+
+// Статистика позиции-очереди; время — модельное
+struct QueueStats {
+    qint64 arrivals{0};
+    qint64 departures{0};
+    double totalWait{0};
+    double maxWait{0};
+    double lengthArea{0};   // Интеграл длины очереди по времени
+    qint64 length{0};
+    qint64 maxLength{0};
+
+    double meanWait() const { return departures > 0 ? totalWait / departures : 0; }
+    double meanLength(double time) const { return time > 0 ? lengthArea / time : double(length); }
+};
+
+// Моделирование во времени с позициями-очередями. Выбор перехода тот же,
+// что в PetriSimulator; задержка перед срабатыванием экспоненциальная
+// с единичной интенсивностью каждого разрешённого перехода. Фишки очередей
+// извлекаются в порядке FIFO, выходные фишки наследуют запись первой
+// извлечённой (время появления, id, атрибут), что позволяет проследить
+// путь заявки через несколько очередей.
+class QueueSimulator
+{
+public:
+    explicit QueueSimulator(const CompiledNet& net, quint32 seed = 1);
+
+    void reset();
+    bool step();
+    // Останавливается в тупике, после maxSteps срабатываний
+    // или по достижении модельного времени maxTime (0 — без ограничения)
+    qint64 run(qint64 maxSteps, double maxTime = 0);
+
+    double time() const { return m_time; }
+    const QVector<int>& marking() const { return m_simulator.marking(); }
+    const QVector<qint64>& firingCounts() const { return m_simulator.firingCounts(); }
+    bool isDeadlocked() const { return m_simulator.isDeadlocked(); }
+
+    // Индексы позиций-очередей в CompiledNet
+    const QVector<int>& queuePlaces() const { return m_queuePlaces; }
+    // Статистика на текущий момент модельного времени
+    QueueStats stats(int place) const;
+    const QueueToken& front(int place) const;
+
+    qint64 liveTokens() const;
+    qint64 memoryBytes() const { return m_pool.memoryBytes(); }
+
+private:
+    void accumulate(int queue);
+
+    CompiledNet m_net;
+    PetriSimulator m_simulator;
+    QRandomGenerator m_random;
+
+    // Пул объявлен раньше очередей: очереди возвращают ему блоки
+    TokenPool m_pool;
+    std::vector<TokenQueue> m_queues;
+    QVector<int> m_queuePlaces;
+    QVector<int> m_queueOf;     // Индекс очереди позиции или -1
+    QVector<QueueStats> m_stats;
+    QVector<double> m_lastChange;
+
+    double m_time{0};
+    quint32 m_nextTokenId{0};
+};
+
+#endif // QUEUESIMULATOR_H
@@ -0,0 +1,150 @@
+// statespace.cpp
+#include "statespace.h"
+#include "petriprofiler.h"
+
+#include <QElapsedTimer>
+#include <cstring>
+
+StateStore::StateStore(int width)
+    : m_width(width),
+    m_table(1024, 0)
+{
+}
+
+quint64 StateStore::hash(const int *marking) const
+{
+    // FNV-1a по словам маркировки
+    quint64 h = 14695981039346656037ULL;
+    for (int i = 0; i < m_width; ++i) {
+        h ^= quint32(marking[i]);
+        h *= 1099511628211ULL;
+    }
+    return h ^ (h >> 29);
+}
+
+bool StateStore::equals(int index, const int *marking) const
+{
+    return std::memcmp(state(index), marking, sizeof(int) * size_t(m_width)) == 0;
+}
+
+int StateStore::find(const int *marking) const
+{
+    const size_t mask = m_table.size() - 1;
+    for (size_t slot = hash(marking) & mask; ; slot = (slot + 1) & mask) {
+        const int entry = m_table[slot];
+        if (entry == 0)
+            return -1;
+        if (equals(entry - 1, marking))
+            return entry - 1;
+    }
+}
+
+int StateStore::insert(const int *marking, bool *inserted)
+{
+    // Заполненность таблицы не выше 1/2
+    if (size_t(m_size + 1) * 2 > m_table.size())
+        grow();
+
+    const size_t mask = m_table.size() - 1;
+    size_t slot = hash(marking) & mask;
+    for (; m_table[slot] != 0; slot = (slot + 1) & mask) {
+#ifdef PETRI_PROFILING
+        m_probes++;
+#endif
+        if (equals(m_table[slot] - 1, marking)) {
+            if (inserted) *inserted = false;
+            return m_table[slot] - 1;
+        }
+    }
+
+    m_data.insert(m_data.end(), marking, marking + m_width);
+    m_table[slot] = ++m_size;
+    if (inserted) *inserted = true;
+    return m_size - 1;
+}
+
+void StateStore::grow()
+{
+    PETRI_PROFILE_SCOPE("statestore.grow");
+    std::vector<int> table(m_table.size() * 2, 0);
+    const size_t mask = table.size() - 1;
+    for (int index = 0; index < m_size; ++index) {
+        size_t slot = hash(state(index)) & mask;
+        while (table[slot] != 0)
+            slot = (slot + 1) & mask;
+        table[slot] = index + 1;
+    }
+    m_table.swap(table);
+}
+
+qint64 StateStore::memoryBytes() const
+{
+    return qint64(m_data.capacity() + m_table.capacity()) * qint64(sizeof(int));
+}
+
+StateSpaceResult StateSpace::explore(const CompiledNet &net, const StateSpaceOptions &options, StateStore *store)
+{
+    PETRI_PROFILE_SCOPE("statespace.explore");
+    StateSpaceResult result;
+    result.placeBounds = net.initialMarking;
+
+    const int width = net.placeCount();
+    QVector<int> next(width);
+    store->insert(net.initialMarking.constData(), nullptr);
+
+    QElapsedTimer timer;
+    timer.start();
+    auto stop = [&](StateSpaceResult::Limit limit) {
+        result.complete = false;
+        result.stoppedBy = limit;
+    };
+
+    for (int current = 0; current < store->size(); ++current) {
+        if (options.cancel && options.cancel->load(std::memory_order_relaxed)) {
+            stop(StateSpaceResult::Cancelled);
+            break;
+        }
+        // Часы опрашиваются раз в 1024 состояния
+        if (options.timeoutMs > 0 && (current & 1023) == 0 && timer.elapsed() > options.timeoutMs) {
+            stop(StateSpaceResult::TimeLimit);
+            break;
+        }
+
+        bool deadlock = true;
+        for (int t = 0; t < net.transitionCount(); ++t) {
+            // Указатель на состояние может смениться при росте хранилища
+            const int* marking = store->state(current);
+            if (!net.isEnabled(marking, t))
+                continue;
+            deadlock = false;
+            result.edges++;
+
+            std::memcpy(next.data(), marking, sizeof(int) * size_t(width));
+            net.fire(next.data(), t);
+
+            if (store->size() >= options.maxStates && store->find(next.constData()) < 0) {
+                stop(StateSpaceResult::StateLimit);
+                continue;
+            }
+            bool inserted = false;
+            store->insert(next.constData(), &inserted);
+            if (inserted) {
+                for (int p = 0; p < width; ++p)
+                    result.placeBounds[p] = qMax(result.placeBounds[p], next[p]);
+            }
+        }
+        if (deadlock)
+            result.deadlocks.append(current);
+
+        if (options.maxMemoryBytes > 0 && store->memoryBytes() > options.maxMemoryBytes) {
+            stop(StateSpaceResult::MemoryLimit);
+            break;
+        }
+    }
+
+    result.states = store->size();
+    PETRI_PROFILE_COUNT("statespace.states", result.states);
+    PETRI_PROFILE_COUNT("statespace.edges", result.edges);
+    PETRI_PROFILE_COUNT("statestore.probes", store->probes());
+    return result;
+}
@@ -0,0 +1,76 @@
+#ifndef STATESPACE_H
+#define STATESPACE_H
+
+#include <QVector>
+#include <atomic>
+#include <vector>
+
+#include "petrisimulator.h"
+
+// Хранилище маркировок: все состояния лежат подряд в одном массиве,
+// поиск — по хеш-таблице с открытой адресацией индексов состояний.
+class StateStore
+{
+public:
+    explicit StateStore(int width);
+
+    // Индекс состояния; inserted сообщает, было ли оно новым
+    int insert(const int* marking, bool* inserted);
+    int find(const int* marking) const;
+
+    const int* state(int index) const { return m_data.data() + qint64(index) * m_width; }
+    int size() const { return m_size; }
+    int width() const { return m_width; }
+    qint64 memoryBytes() const;
+#ifdef PETRI_PROFILING
+    // Число лишних проб хеш-таблицы (коллизий) с момента создания
+    qint64 probes() const { return m_probes; }
+#endif
+
+private:
+    quint64 hash(const int* marking) const;
+    bool equals(int index, const int* marking) const;
+    void grow();
+
+    int m_width;
+    int m_size{0};
+#ifdef PETRI_PROFILING
+    qint64 m_probes{0};     // Только в профилирующей сборке: цикл проб самый горячий
+#endif
+    std::vector<int> m_data;
+    std::vector<int> m_table; // индекс состояния + 1, 0 — пусто
+};
+
+struct StateSpaceOptions {
+    int maxStates{1000000};
+    qint64 maxMemoryBytes{0};         // 0 — без ограничения
+    qint64 timeoutMs{0};              // 0 — без ограничения
+    const std::atomic<bool>* cancel{nullptr};
+};
+
+struct StateSpaceResult {
+    enum Limit {
+        NoLimit,
+        StateLimit,
+        MemoryLimit,
+        TimeLimit,
+        Cancelled
+    };
+
+    int states{0};
+    qint64 edges{0};
+    bool complete{true};    // false — исследование прервано по лимиту
+    Limit stoppedBy{NoLimit};
+    QVector<int> deadlocks; // Индексы тупиковых состояний
+    QVector<int> placeBounds;
+};
+
+// Исследование пространства состояний в ширину. Порядок вставки в
+// хранилище совпадает с порядком обхода, поэтому отдельной очереди нет.
+namespace StateSpace {
+
+StateSpaceResult explore(const CompiledNet& net, const StateSpaceOptions& options, StateStore* store);
+
+}
+
+#endif // STATESPACE_H
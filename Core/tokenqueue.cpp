@@ -0,0 +1,131 @@
+// tokenqueue.cpp
+#include "tokenqueue.h"
+
+#include <utility>
+
+TokenPool::Block *TokenPool::allocate()
+{
+    if (!m_free) {
+        // Новая пачка блоков сразу связывается в список свободных
+        const int count = m_nextSlab;
+        m_nextSlab = qMin(m_nextSlab * 2, 4096);
+        std::unique_ptr<Block[]> slab(new Block[count]);
+        for (int i = 0; i < count; ++i)
+            slab[i].next = i + 1 < count ? &slab[i + 1] : nullptr;
+        m_free = &slab[0];
+        m_capacity += count;
+        m_slabs.push_back(std::move(slab));
+    }
+
+    Block* block = m_free;
+    m_free = block->next;
+    block->next = nullptr;
+    m_inUse++;
+    return block;
+}
+
+void TokenPool::release(Block *block)
+{
+    block->next = m_free;
+    m_free = block;
+    m_inUse--;
+}
+
+TokenQueue::TokenQueue(TokenPool *pool)
+    : m_pool(pool)
+{
+}
+
+TokenQueue::~TokenQueue()
+{
+    clear();
+}
+
+TokenQueue::TokenQueue(TokenQueue &&other) noexcept
+    : m_pool(other.m_pool)
+{
+    swap(other);
+}
+
+TokenQueue &TokenQueue::operator=(TokenQueue &&other) noexcept
+{
+    if (this != &other) {
+        clear();
+        m_pool = other.m_pool;
+        swap(other);
+    }
+    return *this;
+}
+
+void TokenQueue::swap(TokenQueue &other) noexcept
+{
+    std::swap(m_head, other.m_head);
+    std::swap(m_tail, other.m_tail);
+    std::swap(m_spare, other.m_spare);
+    std::swap(m_headIndex, other.m_headIndex);
+    std::swap(m_tailIndex, other.m_tailIndex);
+    std::swap(m_size, other.m_size);
+}
+
+TokenPool::Block *TokenQueue::takeBlock()
+{
+    if (m_spare) {
+        TokenPool::Block* block = m_spare;
+        m_spare = nullptr;
+        block->next = nullptr;
+        return block;
+    }
+    return m_pool->allocate();
+}
+
+void TokenQueue::push(const QueueToken &token)
+{
+    if (!m_tail) {
+        m_head = m_tail = takeBlock();
+        m_headIndex = m_tailIndex = 0;
+    } else if (m_tailIndex == TokenPool::BlockSize) {
+        TokenPool::Block* block = takeBlock();
+        m_tail->next = block;
+        m_tail = block;
+        m_tailIndex = 0;
+    }
+    m_tail->tokens[m_tailIndex++] = token;
+    m_size++;
+}
+
+QueueToken TokenQueue::pop()
+{
+    Q_ASSERT(m_size > 0);
+    const QueueToken token = m_head->tokens[m_headIndex++];
+    m_size--;
+
+    if (m_size == 0) {
+        // Единственный блок остаётся за очередью и заполняется с начала
+        m_headIndex = m_tailIndex = 0;
+    } else if (m_headIndex == TokenPool::BlockSize) {
+        TokenPool::Block* block = m_head;
+        m_head = m_head->next;
+        m_headIndex = 0;
+        if (!m_spare) {
+            block->next = nullptr;
+            m_spare = block;
+        } else {
+            m_pool->release(block);
+        }
+    }
+    return token;
+}
+
+void TokenQueue::clear()
+{
+    while (m_head) {
+        TokenPool::Block* next = m_head->next;
+        m_pool->release(m_head);
+        m_head = next;
+    }
+    if (m_spare)
+        m_pool->release(m_spare);
+    m_head = m_tail = m_spare = nullptr;
+    m_headIndex = m_tailIndex = 0;
+    m_size = 0;
+}
@@ -0,0 +1,81 @@
+#ifndef TOKENQUEUE_H
+#define TOKENQUEUE_H
+
+#include <QtGlobal>
+#include <memory>
+#include <vector>
+
+// Фишка позиции-очереди: запись с отметками времени и атрибутом
+struct QueueToken {
+    double created{0};   // Время появления в сети
+    double enqueued{0};  // Время постановки в текущую очередь
+    quint32 id{0};
+    quint32 attribute{0};
+};
+
+// Пул блоков фишек. Блоки выделяются пачками (slab) и после освобождения
+// возвращаются в список свободных, поэтому при миллионах живых фишек
+// общий распределитель памяти вызывается лишь при росте пула.
+class TokenPool
+{
+public:
+    static const int BlockSize = 256;
+
+    struct Block {
+        QueueToken tokens[BlockSize];
+        Block* next;
+    };
+
+    TokenPool() = default;
+    TokenPool(const TokenPool&) = delete;
+    TokenPool& operator=(const TokenPool&) = delete;
+
+    Block* allocate();
+    void release(Block* block);
+
+    qint64 blocksInUse() const { return m_inUse; }
+    qint64 memoryBytes() const { return m_capacity * qint64(sizeof(Block)); }
+
+private:
+    std::vector<std::unique_ptr<Block[]>> m_slabs;
+    Block* m_free{nullptr};
+    qint64 m_capacity{0};   // Всего блоков во всех пачках
+    qint64 m_inUse{0};
+    int m_nextSlab{16};     // Размер следующей пачки, удваивается до предела
+};
+
+// Очередь FIFO поверх блоков пула: запись в хвостовой блок, чтение из
+// головного; опустевший головной блок уходит в запас очереди или в пул.
+// Запасной блок гасит возврат-захват блока на границе при колебаниях длины.
+class TokenQueue
+{
+public:
+    explicit TokenQueue(TokenPool* pool);
+    ~TokenQueue();
+    TokenQueue(TokenQueue&& other) noexcept;
+    TokenQueue& operator=(TokenQueue&& other) noexcept;
+    TokenQueue(const TokenQueue&) = delete;
+    TokenQueue& operator=(const TokenQueue&) = delete;
+
+    void push(const QueueToken& token);
+    QueueToken pop();
+    const QueueToken& front() const { return m_head->tokens[m_headIndex]; }
+
+    qint64 size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    void clear();
+
+private:
+    TokenPool::Block* takeBlock();
+    void swap(TokenQueue& other) noexcept;
+
+    TokenPool* m_pool;
+    TokenPool::Block* m_head{nullptr};
+    TokenPool::Block* m_tail{nullptr};
+    TokenPool::Block* m_spare{nullptr};
+    int m_headIndex{0};
+    int m_tailIndex{0};     // Первая свободная ячейка хвостового блока
+    qint64 m_size{0};
+};
+
+#endif // TOKENQUEUE_H
@@ -0,0 +1,676 @@
+// unfolding.cpp
+#include "unfolding.h"
+#include "petriprofiler.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <algorithm>
+
+namespace {
+
+// Проверка отмены раз в несколько тысяч шагов: атомарное чтение дешёвое,
+// но не бесплатное на самом частом пути поиска
+bool stopSearch(qint64 steps, qint64 budget, const std::atomic<bool>* cancel)
+{
+    if (steps > budget)
+        return true;
+    return cancel && (steps & 4095) == 0 && cancel->load(std::memory_order_relaxed);
+}
+
+// Сравнение векторов Париха, заданных отсортированными списками переходов:
+// меньше тот, у кого при первом различии меньше вхождений меньшего перехода
+int compareParikh(const int* a, int aSize, const int* b, int bSize)
+{
+    int i = 0;
+    int j = 0;
+    while (i < aSize && j < bSize) {
+        if (a[i] != b[j])
+            return a[i] < b[j] ? 1 : -1;
+        ++i;
+        ++j;
+    }
+    if (i < aSize) return 1;
+    if (j < bSize) return -1;
+    return 0;
+}
+
+std::vector<int> sortedUnion(const std::vector<int>& a, const std::vector<int>& b)
+{
+    std::vector<int> result;
+    result.reserve(a.size() + b.size());
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+    return result;
+}
+
+}
+
+struct Unfolding::Extension {
+    int transition;
+    int depth;
+    std::vector<int> preset;   // Условия, по возрастанию
+    std::vector<int> config;   // Локальная конфигурация без нового события
+    std::vector<int> parikh;   // Переходы конфигурации с новым, по возрастанию
+};
+
+// Адекватный порядок ERV; как компаратор кучи возвращает true,
+// если a идёт после b, чтобы вершиной была минимальная конфигурация
+class Unfolding::ExtensionOrder
+{
+public:
+    explicit ExtensionOrder(const Unfolding* unfolding)
+        : m_unfolding(unfolding)
+    {
+    }
+
+    bool operator()(const Extension& a, const Extension& b) const
+    {
+        return compare(a, b) > 0;
+    }
+
+    int compare(const Extension& a, const Extension& b) const
+    {
+        if (a.config.size() != b.config.size())
+            return a.config.size() < b.config.size() ? -1 : 1;
+        const int parikh = compareParikh(a.parikh.data(), int(a.parikh.size()), b.parikh.data(), int(b.parikh.size()));
+        if (parikh != 0)
+            return parikh;
+        return compareFoata(a, b);
+    }
+
+private:
+    // Уровни Фоаты: пары (глубина, переход) по возрастанию
+    std::vector<std::pair<int, int>> levels(const Extension& extension) const
+    {
+        std::vector<std::pair<int, int>> result;
+        result.reserve(extension.config.size() + 1);
+        for (int event : extension.config) {
+            const Event& e = m_unfolding->m_events[event];
+            result.push_back({e.depth, e.transition});
+        }
+        result.push_back({extension.depth, extension.transition});
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    int compareFoata(const Extension& a, const Extension& b) const
+    {
+        const std::vector<std::pair<int, int>> first = levels(a);
+        const std::vector<std::pair<int, int>> second = levels(b);
+        size_t i = 0;
+        size_t j = 0;
+        std::vector<int> left;
+        std::vector<int> right;
+        while (i < first.size() && j < second.size()) {
+            const int depth = qMin(first[i].first, second[j].first);
+            left.clear();
+            right.clear();
+            for (; i < first.size() && first[i].first == depth; ++i)
+                left.push_back(first[i].second);
+            for (; j < second.size() && second[j].first == depth; ++j)
+                right.push_back(second[j].second);
+            const int result = compareParikh(left.data(), int(left.size()), right.data(), int(right.size()));
+            if (result != 0)
+                return result;
+        }
+        return 0;
+    }
+
+    const Unfolding* m_unfolding;
+};
+
+Unfolding::Extension Unfolding::localExtension(int event) const
+{
+    const Event& e = m_events[event];
+    Extension extension;
+    extension.transition = e.transition;
+    extension.depth = e.depth;
+    extension.preset = std::vector<int>(e.preset.begin(), e.preset.end());
+    extension.config = m_local[size_t(event)];
+    extension.config.pop_back();
+    for (int other : m_local[size_t(event)])
+        extension.parikh.push_back(m_events[other].transition);
+    std::sort(extension.parikh.begin(), extension.parikh.end());
+    return extension;
+}
+
+int Unfolding::addCondition(int place, int preEvent, bool live)
+{
+    m_conditions.append({place, preEvent, {}, live});
+    m_co.emplace_back();
+    return m_conditions.size() - 1;
+}
+
+bool Unfolding::isCo(int first, int second) const
+{
+    const std::vector<int>& co = m_co[size_t(first)];
+    return std::binary_search(co.begin(), co.end(), second);
+}
+
+bool Unfolding::isDead(const QVector<int> &marking) const
+{
+    for (int t = 0; t < m_net.transitionCount(); ++t) {
+        if (m_net.isEnabled(marking.constData(), t))
+            return false;
+    }
+    return true;
+}
+
+QVector<int> Unfolding::markingOf(const std::vector<int> &configuration) const
+{
+    QVector<int> marking = m_net.initialMarking;
+    for (int event : configuration) {
+        const int t = m_events[event].transition;
+        for (int i = m_net.inputStart[t]; i < m_net.inputStart[t + 1]; ++i)
+            marking[m_net.inputs[i].place] -= 1;
+        for (int i = m_net.outputStart[t]; i < m_net.outputStart[t + 1]; ++i)
+            marking[m_net.outputs[i].place] += 1;
+    }
+    return marking;
+}
+
+void Unfolding::addExtensions(int firstNew, int endNew, std::vector<Extension> *queue, const ExtensionOrder &order)
+{
+    // Каждое расширение порождается один раз — от наименьшего нового
+    // условия в его предусловии; новые условия с меньшим id исключаются
+    for (int c = firstNew; c < endNew; ++c) {
+        const int place = m_conditions[c].place;
+
+        // Кандидаты из co(c), сгруппированные по позициям
+        QHash<int, std::vector<int>> byPlace;
+        for (int other : m_co[size_t(c)]) {
+            if (other >= firstNew && other < c)
+                continue;
+            byPlace[m_conditions[other].place].push_back(other);
+        }
+
+        for (int t : m_consumers[place]) {
+            QVector<int> slots;     // Остальные входные позиции перехода
+            bool possible = true;
+            for (int i = m_net.inputStart[t]; i < m_net.inputStart[t + 1]; ++i) {
+                const int input = m_net.inputs[i].place;
+                if (input == place)
+                    continue;
+                if (!byPlace.contains(input)) {
+                    possible = false;
+                    break;
+                }
+                slots.append(input);
+            }
+            if (!possible)
+                continue;
+
+            // Перебор попарно параллельных кандидатов по позициям
+            std::vector<int> chosen(size_t(slots.size()), -1);
+            std::vector<size_t> cursor(size_t(slots.size()), 0);
+            int level = 0;
+            while (level >= 0) {
+                if (level == slots.size()) {
+                    Extension extension;
+                    extension.transition = t;
+                    extension.preset = chosen;
+                    extension.preset.push_back(c);
+                    std::sort(extension.preset.begin(), extension.preset.end());
+
+                    int depth = 0;
+                    for (int b : extension.preset) {
+                        const int pre = m_conditions[b].preEvent;
+                        if (pre < 0) continue;
+                        extension.config = sortedUnion(extension.config, m_local[size_t(pre)]);
+                        depth = qMax(depth, m_events[pre].depth);
+                    }
+                    extension.depth = depth + 1;
+                    extension.parikh.reserve(extension.config.size() + 1);
+                    for (int event : extension.config)
+                        extension.parikh.push_back(m_events[event].transition);
+                    extension.parikh.push_back(t);
+                    std::sort(extension.parikh.begin(), extension.parikh.end());
+
+                    queue->push_back(std::move(extension));
+                    std::push_heap(queue->begin(), queue->end(), order);
+                    --level;
+                    continue;
+                }
+
+                const std::vector<int>& candidates = byPlace[slots[level]];
+                size_t& next = cursor[size_t(level)];
+                bool advanced = false;
+                while (next < candidates.size()) {
+                    const int candidate = candidates[next++];
+                    bool co = true;
+                    for (int k = 0; k < level && co; ++k)
+                        co = isCo(chosen[size_t(k)], candidate);
+                    if (co) {
+                        chosen[size_t(level)] = candidate;
+                        advanced = true;
+                        break;
+                    }
+                }
+                if (advanced) {
+                    ++level;
+                    if (level < slots.size())
+                        cursor[size_t(level)] = 0;
+                } else {
+                    --level;
+                }
+            }
+        }
+    }
+}
+
+Unfolding Unfolding::build(const CompiledNet &net, const UnfoldingOptions &options, QString *error)
+{
+    PETRI_PROFILE_SCOPE("unfolding.build");
+    Unfolding unfolding;
+    unfolding.m_net = net;
+
+    // Кратные дуги и веса больше 1 развёртка не поддерживает
+    unfolding.m_consumers.resize(net.placeCount());
+    for (int t = 0; t < net.transitionCount(); ++t) {
+        QVector<int> places;
+        for (int i = net.inputStart[t]; i < net.inputStart[t + 1]; ++i) {
+            if (net.inputs[i].weight != 1 || places.contains(net.inputs[i].place)) {
+                if (error) *error = "Unfolding supports only unit arc weights";
+                unfolding.m_complete = false;
+                unfolding.m_stopReason = "unsupported";
+                return unfolding;
+            }
+            places.append(net.inputs[i].place);
+            unfolding.m_consumers[net.inputs[i].place].append(t);
+        }
+        for (int i = net.outputStart[t]; i < net.outputStart[t + 1]; ++i) {
+            if (net.outputs[i].weight != 1) {
+                if (error) *error = "Unfolding supports only unit arc weights";
+                unfolding.m_complete = false;
+                unfolding.m_stopReason = "unsupported";
+                return unfolding;
+            }
+        }
+    }
+
+    // Начальные условия попарно параллельны
+    for (int p = 0; p < net.placeCount(); ++p) {
+        for (int k = 0; k < net.initialMarking[p]; ++k)
+            unfolding.addCondition(p, -1, true);
+    }
+    const int initial = unfolding.m_conditions.size();
+    for (int c = 0; c < initial; ++c) {
+        for (int other = 0; other < initial; ++other) {
+            if (other != c)
+                unfolding.m_co[size_t(c)].push_back(other);
+        }
+    }
+
+    QHash<QVector<int>, int> markings;
+    markings.insert(net.initialMarking, -1);
+
+    const ExtensionOrder order(&unfolding);
+    std::vector<Extension> queue;
+    unfolding.addExtensions(0, initial, &queue, order);
+
+    QElapsedTimer timer;
+    timer.start();
+    while (!queue.empty()) {
+        if (unfolding.m_events.size() >= options.maxEvents) {
+            unfolding.m_complete = false;
+            unfolding.m_stopReason = "events";
+            break;
+        }
+        if (options.cancel && options.cancel->load(std::memory_order_relaxed)) {
+            unfolding.m_complete = false;
+            unfolding.m_stopReason = "cancelled";
+            break;
+        }
+        if (options.timeoutMs > 0 && (unfolding.m_events.size() & 255) == 0 && timer.elapsed() > options.timeoutMs) {
+            unfolding.m_complete = false;
+            unfolding.m_stopReason = "timeout";
+            break;
+        }
+
+        std::pop_heap(queue.begin(), queue.end(), order);
+        Extension extension = std::move(queue.back());
+        queue.pop_back();
+
+        const int id = unfolding.m_events.size();
+        QVector<int> marking = unfolding.markingOf(extension.config);
+        net.fire(marking.data(), extension.transition);
+        std::vector<int> local = std::move(extension.config);
+        local.push_back(id);    // id больше всех событий конфигурации
+
+        // Конфигурации извлекаются по возрастанию порядка, поэтому событие
+        // с той же маркировкой, добавленное раньше, не больше текущего.
+        // В небезопасной сети порядок бывает равным — такое событие не отсекается
+        const auto seen = markings.constFind(marking);
+        const bool known = seen != markings.constEnd();
+        bool cutoff = known;
+        if (known && seen.value() >= 0) {
+            extension.config = local;
+            extension.config.pop_back();
+            cutoff = order.compare(unfolding.localExtension(seen.value()), extension) < 0;
+            extension.config.clear();
+        }
+
+        Event event;
+        event.transition = extension.transition;
+        event.preset = QVector<int>(extension.preset.begin(), extension.preset.end());
+        event.depth = extension.depth;
+        event.cutoff = cutoff;
+        event.companion = cutoff ? seen.value() : -1;
+        unfolding.m_events.append(event);
+        unfolding.m_local.push_back(std::move(local));
+        if (cutoff)
+            unfolding.m_cutoffs++;
+        else if (!known)
+            markings.insert(marking, id);
+
+        for (int b : extension.preset)
+            unfolding.m_conditions[b].postEvents.append(id);
+
+        const int firstNew = unfolding.m_conditions.size();
+        const int t = extension.transition;
+        for (int i = net.outputStart[t]; i < net.outputStart[t + 1]; ++i)
+            unfolding.m_events[id].postset.append(unfolding.addCondition(net.outputs[i].place, id, !cutoff));
+        const int endNew = unfolding.m_conditions.size();
+
+        // Постусловия отсечённого события не участвуют в co и расширениях
+        if (cutoff)
+            continue;
+
+        // co(новое) = пересечение co предусловий + остальные новые условия;
+        // новые id больше всех прежних, поэтому добавление в конец сохраняет порядок
+        std::vector<int> base = unfolding.m_co[size_t(extension.preset.front())];
+        for (size_t k = 1; k < extension.preset.size(); ++k) {
+            const std::vector<int>& co = unfolding.m_co[size_t(extension.preset[k])];
+            std::vector<int> common;
+            std::set_intersection(base.begin(), base.end(), co.begin(), co.end(), std::back_inserter(common));
+            base.swap(common);
+        }
+        for (int x : base) {
+            for (int c = firstNew; c < endNew; ++c)
+                unfolding.m_co[size_t(x)].push_back(c);
+        }
+        for (int c = firstNew; c < endNew; ++c) {
+            std::vector<int>& co = unfolding.m_co[size_t(c)];
+            co = base;
+            for (int other = firstNew; other < endNew; ++other) {
+                if (other != c)
+                    co.push_back(other);
+            }
+        }
+
+        unfolding.addExtensions(firstNew, endNew, &queue, order);
+    }
+
+    PETRI_PROFILE_COUNT("unfolding.events", unfolding.m_events.size());
+    PETRI_PROFILE_COUNT("unfolding.cutoffs", unfolding.m_cutoffs);
+    return unfolding;
+}
+
+Unfolding::Verdict Unfolding::findDeadlock(QVector<int> *marking, qint64 budget, const std::atomic<bool> *cancel) const
+{
+    PETRI_PROFILE_SCOPE("unfolding.deadlock");
+    const int count = m_events.size();
+
+    // Наибольший id события, конфликтующего с данным (общее предусловие)
+    QVector<int> maxConflict(count, -1);
+    for (int e = 0; e < count; ++e) {
+        for (int b : m_events[e].preset) {
+            for (int other : m_conditions[b].postEvents) {
+                if (other != e)
+                    maxConflict[e] = qMax(maxConflict[e], other);
+            }
+        }
+    }
+
+    // Перебор конфигураций в порядке id (он топологический): событие либо
+    // входит в конфигурацию, либо нет. Разрешённое невключённое событие
+    // должно быть позже заблокировано конфликтующим — иначе ветвь отсекается.
+    std::vector<char> inConfig(size_t(count), 0);
+    std::vector<char> consumed(size_t(m_conditions.size()), 0);
+    std::vector<char> choice(size_t(count), -1);
+    std::vector<char> pushedOpen(size_t(count), 0);
+    std::vector<int> open;
+
+    auto enabled = [&](int e) {
+        for (int b : m_events[e].preset) {
+            const int pre = m_conditions[b].preEvent;
+            if (consumed[size_t(b)] || (pre >= 0 && !inConfig[size_t(pre)]))
+                return false;
+        }
+        return true;
+    };
+    auto openAlive = [&](int position) {
+        for (int e : open) {
+            if (maxConflict[e] < position && enabled(e))
+                return false;
+        }
+        return true;
+    };
+    auto include = [&](int e, bool in) {
+        inConfig[size_t(e)] = in;
+        for (int b : m_events[e].preset)
+            consumed[size_t(b)] = in;
+    };
+    auto exclude = [&](int e) {
+        pushedOpen[size_t(e)] = enabled(e);
+        if (pushedOpen[size_t(e)])
+            open.push_back(e);
+    };
+    auto canExclude = [&](int e) { return !enabled(e) || maxConflict[e] > e; };
+
+    int i = 0;
+    bool backtracking = false;
+    qint64 steps = 0;
+    while (true) {
+        if (stopSearch(++steps, budget, cancel))
+            return Unknown;
+
+        if (!backtracking) {
+            if (i == count) {
+                if (openAlive(count)) {
+                    std::vector<int> configuration;
+                    for (int e = 0; e < count; ++e) {
+                        if (inConfig[size_t(e)])
+                            configuration.push_back(e);
+                    }
+                    const QVector<int> dead = markingOf(configuration);
+                    // Проверка по исходной сети делает ответ надёжным и для неполного префикса
+                    if (isDead(dead)) {
+                        if (marking) *marking = dead;
+                        return Yes;
+                    }
+                }
+                backtracking = true;
+                continue;
+            }
+            if (!openAlive(i)) {
+                backtracking = true;
+                continue;
+            }
+            if (!m_events[i].cutoff && enabled(i)) {
+                include(i, true);
+                choice[size_t(i)] = 1;
+                ++i;
+            } else if (canExclude(i)) {
+                exclude(i);
+                choice[size_t(i)] = 0;
+                ++i;
+            } else {
+                backtracking = true;
+            }
+            continue;
+        }
+
+        if (i == 0)
+            return m_complete ? No : Unknown;
+        --i;
+        if (choice[size_t(i)] == 1) {
+            include(i, false);
+            if (canExclude(i)) {
+                exclude(i);
+                choice[size_t(i)] = 0;
+                ++i;
+                backtracking = false;
+            } else {
+                choice[size_t(i)] = -1;
+            }
+        } else if (choice[size_t(i)] == 0) {
+            if (pushedOpen[size_t(i)])
+                open.pop_back();
+            choice[size_t(i)] = -1;
+        }
+    }
+}
+
+bool Unfolding::consumeExtra(std::vector<char> *cut, const std::vector<char> &target, int pending, int after,
+                             qint64 *steps, qint64 budget, const std::atomic<bool> *cancel) const
+{
+    if (pending == 0)
+        return true;
+    if (stopSearch(++*steps, budget, cancel))
+        return false;
+
+    // События добавляются по возрастанию id (порядок топологический),
+    // поэтому каждое продолжение перебирается один раз. Лишнее условие
+    // без потребителей позже after уже не поглотить.
+    std::vector<int> candidates;
+    for (int c = 0; c < m_conditions.size(); ++c) {
+        if (!(*cut)[size_t(c)] || target[size_t(c)])
+            continue;
+        bool consumable = false;
+        for (int e : m_conditions[c].postEvents) {
+            if (e > after && !m_events[e].cutoff) {
+                candidates.push_back(e);
+                consumable = true;
+            }
+        }
+        if (!consumable)
+            return false;
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    for (int e : candidates) {
+        const Event& event = m_events[e];
+        bool enabled = true;
+        for (int b : event.preset) {
+            if (!(*cut)[size_t(b)] || target[size_t(b)]) {
+                enabled = false;
+                break;
+            }
+        }
+        if (!enabled)
+            continue;
+
+        for (int b : event.preset) (*cut)[size_t(b)] = 0;
+        for (int b : event.postset) (*cut)[size_t(b)] = 1;
+        const int left = pending - event.preset.size() + event.postset.size();
+        const bool found = consumeExtra(cut, target, left, e, steps, budget, cancel);
+        for (int b : event.postset) (*cut)[size_t(b)] = 0;
+        for (int b : event.preset) (*cut)[size_t(b)] = 1;
+        if (found)
+            return true;
+    }
+    return false;
+}
+
+Unfolding::Verdict Unfolding::findMarking(const QVector<int> &marking, bool exact, qint64 budget,
+                                          const std::atomic<bool> *cancel) const
+{
+    PETRI_PROFILE_SCOPE("unfolding.marking");
+
+    // Слоты фишек целевой маркировки и живые условия каждой позиции
+    QVector<int> slots;
+    for (int p = 0; p < marking.size(); ++p) {
+        for (int k = 0; k < marking[p]; ++k)
+            slots.append(p);
+    }
+    QHash<int, QVector<int>> candidates;
+    for (int c = 0; c < m_conditions.size(); ++c) {
+        if (m_conditions[c].live && marking.value(m_conditions[c].place) > 0)
+            candidates[m_conditions[c].place].append(c);
+    }
+
+    qint64 steps = 0;
+    auto matches = [&](const std::vector<int>& chosen) {
+        if (!exact)
+            return true;
+        // Прошлое выбранных условий; прочие условия его разреза должны
+        // быть поглощены событиями вне прошлого (переходы без выходов)
+        std::vector<int> configuration;
+        for (int b : chosen) {
+            const int pre = m_conditions[b].preEvent;
+            if (pre >= 0)
+                configuration = sortedUnion(configuration, m_local[size_t(pre)]);
+        }
+        std::vector<char> cut(size_t(m_conditions.size()), 0);
+        std::vector<char> target(size_t(m_conditions.size()), 0);
+        for (int c = 0; c < m_conditions.size() && m_conditions[c].preEvent < 0; ++c)
+            cut[size_t(c)] = 1;
+        for (int e : configuration) {
+            for (int b : m_events[e].preset) cut[size_t(b)] = 0;
+            for (int b : m_events[e].postset) cut[size_t(b)] = 1;
+        }
+        for (int b : chosen)
+            target[size_t(b)] = 1;
+        int pending = -int(chosen.size());
+        for (char in : cut)
+            pending += in;
+        return consumeExtra(&cut, target, pending, -1, &steps, budget, cancel);
+    };
+
+    std::vector<int> chosen(size_t(slots.size()), -1);
+    std::vector<int> cursor(size_t(slots.size()), 0);
+    int level = 0;
+    // Поиск продолжения в matches мог быть прерван отменой или бюджетом
+    auto interrupted = [&]() {
+        return steps > budget || (cancel && cancel->load(std::memory_order_relaxed));
+    };
+    if (slots.isEmpty()) {
+        if (matches(chosen))
+            return Yes;
+        return m_complete && !interrupted() ? No : Unknown;
+    }
+
+    while (level >= 0) {
+        if (stopSearch(++steps, budget, cancel))
+            return Unknown;
+        if (level == slots.size()) {
+            if (matches(chosen))
+                return Yes;
+            if (interrupted())
+                return Unknown;
+            --level;
+            continue;
+        }
+
+        // Фишки одной позиции берутся по возрастанию id, без перестановок
+        const QVector<int>& list = candidates[slots[level]];
+        int& next = cursor[size_t(level)];
+        if (level > 0 && slots[level - 1] == slots[level] && next == 0) {
+            const int previous = chosen[size_t(level - 1)];
+            next = int(std::upper_bound(list.begin(), list.end(), previous) - list.begin());
+        }
+
+        bool advanced = false;
+        while (next < list.size()) {
+            const int candidate = list[next++];
+            bool co = true;
+            for (int k = 0; k < level && co; ++k)
+                co = isCo(chosen[size_t(k)], candidate);
+            if (co) {
+                chosen[size_t(level)] = candidate;
+                advanced = true;
+                break;
+            }
+        }
+        if (advanced) {
+            ++level;
+            if (level < slots.size())
+                cursor[size_t(level)] = 0;
+        } else {
+            cursor[size_t(level)] = 0;
+            --level;
+        }
+    }
+    return m_complete ? No : Unknown;
+}
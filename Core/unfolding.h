@@ -0,0 +1,98 @@
+#ifndef UNFOLDING_H
+#define UNFOLDING_H
+
+#include <QVector>
+#include <QString>
+#include <atomic>
+#include <vector>
+
+#include "petrisimulator.h"
+
+struct UnfoldingOptions {
+    int maxEvents{200000};
+    qint64 timeoutMs{0};       // 0 — без ограничения
+    const std::atomic<bool>* cancel{nullptr};
+};
+
+// Полный конечный префикс развёртки (McMillan, Esparza–Römer–Vogler).
+// События добавляются в порядке адекватного порядка ERV на локальных
+// конфигурациях: размер, вектор Париха, нормальная форма Фоаты. Событие
+// отсекается, если ту же маркировку даёт строго меньшая локальная
+// конфигурация (поиск по хешу маркировки). Для каждого условия хранится
+// множество параллельных ему условий (co), по которому ищутся расширения.
+//
+// Поддерживаются ограниченные сети с единичными весами дуг.
+class Unfolding
+{
+public:
+    struct Condition {
+        int place;
+        int preEvent;           // -1 — условие начальной маркировки
+        QVector<int> postEvents;
+        bool live;              // false — в постусловии отсечённого события
+    };
+
+    struct Event {
+        int transition;
+        QVector<int> preset;    // Условия
+        QVector<int> postset;
+        int depth;              // Уровень в нормальной форме Фоаты
+        bool cutoff;
+        int companion;          // Событие с той же маркировкой, -1 — начальная
+    };
+
+    enum Verdict {
+        No,
+        Yes,
+        Unknown     // Префикс неполон или исчерпан бюджет поиска
+    };
+
+    static Unfolding build(const CompiledNet& net, const UnfoldingOptions& options = UnfoldingOptions(),
+                           QString* error = nullptr);
+
+    const QVector<Event>& events() const { return m_events; }
+    const QVector<Condition>& conditions() const { return m_conditions; }
+    int cutoffCount() const { return m_cutoffs; }
+    // false — построение прервано по лимиту (причина в stopReason())
+    bool isComplete() const { return m_complete; }
+    QString stopReason() const { return m_stopReason; }
+
+    // Тупик: конфигурация без отсечённых событий, после которой в префиксе
+    // не разрешено ни одно событие. budget — предел числа шагов поиска,
+    // cancel прерывает поиск (ответ Unknown).
+    Verdict findDeadlock(QVector<int>* marking = nullptr, qint64 budget = 10000000,
+                         const std::atomic<bool>* cancel = nullptr) const;
+
+    // Достижимость маркировки (exact) или покрытие: поиск co-множества
+    // условий с нужными метками и проверка разреза его прошлого
+    Verdict findMarking(const QVector<int>& marking, bool exact, qint64 budget = 10000000,
+                        const std::atomic<bool>* cancel = nullptr) const;
+
+    QVector<int> markingOf(const std::vector<int>& configuration) const;
+
+private:
+    struct Extension;
+    class ExtensionOrder;
+
+    Extension localExtension(int event) const;
+    int addCondition(int place, int preEvent, bool live);
+    void addExtensions(int firstNew, int endNew, std::vector<Extension>* queue, const ExtensionOrder& order);
+    bool isCo(int first, int second) const;
+    bool isDead(const QVector<int>& marking) const;
+    bool consumeExtra(std::vector<char>* cut, const std::vector<char>& target, int pending, int after,
+                      qint64* steps, qint64 budget, const std::atomic<bool>* cancel) const;
+
+    CompiledNet m_net;
+    QVector<Condition> m_conditions;
+    QVector<Event> m_events;
+    QVector<QVector<int>> m_consumers;      // Переходы, потребляющие из позиции
+
+    std::vector<std::vector<int>> m_co;     // Отсортированные co-множества живых условий
+    std::vector<std::vector<int>> m_local;  // Локальные конфигурации событий
+
+    int m_cutoffs{0};
+    bool m_complete{true};
+    QString m_stopReason;
+};
+
+#endif // UNFOLDING_H
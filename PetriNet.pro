@@ -1,4 +1,4 @@
-QT       += core gui
+QT       += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -8,20 +8,15 @@ CONFIG += c++17
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+include(Core/core.pri)
+include(Scene/scene.pri)
+
 SOURCES += \
     main.cpp \
-    mainwindow.cpp \
-    Scene/Items/petriarc.cpp \
-    Scene/petrinetscene.cpp \
-    Scene/Items/petriplace.cpp \
-    Scene/Items/petritransition.cpp
+    mainwindow.cpp
 
 HEADERS += \
-    mainwindow.h \
-    Scene/Items/petriarc.h \
-    Scene/petrinetscene.h \
-    Scene/Items/petriplace.h \
-    Scene/Items/petritransition.h
+    mainwindow.h
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
@@ -0,0 +1,247 @@
+// petricommands.cpp
+#include "petricommands.h"
+#include "../petrinetscene.h"
+
+#include <QSet>
+
+namespace {
+// Идентификатор для слияния последовательных изменений фишек одной позиции
+const int SetTokensCommandId = 1;
+}
+
+AddNodeCommand::AddNodeCommand(PetriNetScene *scene, QGraphicsItem *node, QUndoCommand *parent)
+    : QUndoCommand(parent),
+    m_scene(scene),
+    m_node(node)
+{
+    setText(qgraphicsitem_cast<PetriPlace*>(node) ? "Добавить позицию" : "Добавить переход");
+}
+
+AddNodeCommand::~AddNodeCommand()
+{
+    if (m_ownsNode)
+        delete m_node;
+}
+
+void AddNodeCommand::undo()
+{
+    m_scene->detachNode(m_node);
+    m_ownsNode = true;
+}
+
+void AddNodeCommand::redo()
+{
+    m_scene->attachNode(m_node);
+    m_ownsNode = false;
+}
+
+AddArcCommand::AddArcCommand(PetriNetScene *scene, PetriArc *arc, QUndoCommand *parent)
+    : QUndoCommand(parent),
+    m_scene(scene),
+    m_arc(arc)
+{
+    setText("Добавить дугу");
+}
+
+AddArcCommand::~AddArcCommand()
+{
+    if (m_ownsArc)
+        delete m_arc;
+}
+
+void AddArcCommand::undo()
+{
+    m_scene->detachArc(m_arc);
+    m_ownsArc = true;
+}
+
+void AddArcCommand::redo()
+{
+    m_scene->attachArc(m_arc);
+    m_ownsArc = false;
+}
+
+RemoveItemsCommand::RemoveItemsCommand(PetriNetScene *scene, const QList<QGraphicsItem *> &items, QUndoCommand *parent)
+    : QUndoCommand(parent),
+    m_scene(scene)
+{
+    // Каскад: для каждого узла берём инцидентные дуги из индекса смежности,
+    // поэтому стоимость пропорциональна сумме степеней удаляемых узлов
+    QSet<PetriArc*> arcs;
+    for (QGraphicsItem* item : items) {
+        if (PetriArc* arc = qgraphicsitem_cast<PetriArc*>(item)) {
+            arcs.insert(arc);
+        }
+        else if (PetriPlace* place = qgraphicsitem_cast<PetriPlace*>(item)) {
+            m_nodes.append(place);
+            for (PetriArc* arc : place->arcs())
+                arcs.insert(arc);
+        }
+        else if (PetriTransition* transition = qgraphicsitem_cast<PetriTransition*>(item)) {
+            m_nodes.append(transition);
+            for (PetriArc* arc : transition->arcs())
+                arcs.insert(arc);
+        }
+    }
+    m_arcs.reserve(arcs.size());
+    for (PetriArc* arc : arcs)
+        m_arcs.append(arc);
+
+    setText(m_nodes.isEmpty() && m_arcs.size() == 1 ? "Удалить дугу" : "Удалить элементы");
+}
+
+RemoveItemsCommand::~RemoveItemsCommand()
+{
+    if (m_ownsItems) {
+        qDeleteAll(m_arcs);
+        qDeleteAll(m_nodes);
+    }
+}
+
+void RemoveItemsCommand::undo()
+{
+    for (QGraphicsItem* node : m_nodes)
+        m_scene->attachNode(node);
+    for (PetriArc* arc : m_arcs)
+        m_scene->attachArc(arc);
+    m_ownsItems = false;
+}
+
+void RemoveItemsCommand::redo()
+{
+    for (PetriArc* arc : m_arcs)
+        m_scene->detachArc(arc);
+    for (QGraphicsItem* node : m_nodes)
+        m_scene->detachNode(node);
+    m_ownsItems = true;
+}
+
+bool RemoveItemsCommand::isEmpty() const
+{
+    return m_nodes.isEmpty() && m_arcs.isEmpty();
+}
+
+MoveItemsCommand::MoveItemsCommand(PetriNetScene *scene, const QVector<Move> &moves, QUndoCommand *parent)
+    : QUndoCommand(parent),
+    m_scene(scene),
+    m_moves(moves)
+{
+    setText(moves.size() == 1 ? "Переместить элемент" : "Переместить элементы");
+}
+
+void MoveItemsCommand::undo()
+{
+    for (const Move& move : m_moves)
+        m_scene->moveNode(move.item, move.from);
+    m_scene->update();
+}
+
+void MoveItemsCommand::redo()
+{
+    for (const Move& move : m_moves)
+        m_scene->moveNode(move.item, move.to);
+    m_scene->update();
+}
+
+SetTokensCommand::SetTokensCommand(PetriNetScene *scene, PetriPlace *place, int tokens, QUndoCommand *parent)
+    : QUndoCommand(parent),
+    m_scene(scene),
+    m_place(place),
+    m_oldTokens(place->tokens()),
+    m_newTokens(tokens)
+{
+    setText("Изменить фишки " + place->label());
+}
+
+void SetTokensCommand::undo()
+{
+    m_scene->changeTokens(m_place, m_oldTokens);
+}
+
+void SetTokensCommand::redo()
+{
+    m_scene->changeTokens(m_place, m_newTokens);
+}
+
+int SetTokensCommand::id() const
+{
+    return SetTokensCommandId;
+}
+
+bool SetTokensCommand::mergeWith(const QUndoCommand *other)
+{
+    const SetTokensCommand* command = static_cast<const SetTokensCommand*>(other);
+    if (command->m_place != m_place)
+        return false;
+    m_newTokens = command->m_newTokens;
+    return true;
+}
+
+SetWeightCommand::SetWeightCommand(PetriNetScene *scene, PetriArc *arc, int weight, QUndoCommand *parent)
+    : QUndoCommand(parent),
+    m_scene(scene),
+    m_arc(arc),
+    m_oldWeight(arc->weight()),
+    m_newWeight(weight)
+{
+    setText("Изменить вес дуги");
+}
+
+void SetWeightCommand::undo()
+{
+    m_scene->changeWeight(m_arc, m_oldWeight);
+}
+
+void SetWeightCommand::redo()
+{
+    m_scene->changeWeight(m_arc, m_newWeight);
+}
+
+SetQueueModeCommand::SetQueueModeCommand(PetriNetScene *scene, PetriPlace *place, bool queue, QUndoCommand *parent)
+    : QUndoCommand(parent),
+    m_scene(scene),
+    m_place(place),
+    m_queue(queue)
+{
+    setText(queue ? "Сделать очередью" : "Отменить режим очереди");
+}
+
+void SetQueueModeCommand::undo()
+{
+    m_scene->changeQueueMode(m_place, !m_queue);
+}
+
+void SetQueueModeCommand::redo()
+{
+    m_scene->changeQueueMode(m_place, m_queue);
+}
+
+SetSubnetCommand::SetSubnetCommand(PetriNetScene *scene, PetriTransition *transition, int subnet,
+                                   const QHash<int, int> &ports, const SubnetPage &created, QUndoCommand *parent)
+    : QUndoCommand(parent),
+    m_scene(scene),
+    m_transition(transition),
+    m_oldSubnet(transition->subnet()),
+    m_oldPorts(transition->ports()),
+    m_newSubnet(subnet),
+    m_newPorts(ports),
+    m_page(created),
+    m_createsPage(!created.net.isNull())
+{
+    setText(m_createsPage ? "Создать подсеть" : "Назначить подсеть");
+}
+
+void SetSubnetCommand::undo()
+{
+    m_scene->changeSubnet(m_transition, m_oldSubnet, m_oldPorts);
+    // Страница могла измениться после создания — при повторе вернётся она же
+    if (m_createsPage)
+        m_page = m_scene->removeSubnetPage(m_newSubnet);
+}
+
+void SetSubnetCommand::redo()
+{
+    if (m_createsPage)
+        m_scene->insertSubnetPage(m_newSubnet, m_page);
+    m_scene->changeSubnet(m_transition, m_newSubnet, m_newPorts);
+}
@@ -0,0 +1,164 @@
+#ifndef PETRICOMMANDS_H
+#define PETRICOMMANDS_H
+
+#include <QUndoCommand>
+#include <QGraphicsItem>
+#include <QPointF>
+#include <QVector>
+#include <QList>
+#include <QHash>
+
+#include "../../Core/petrinetmodel.h"
+
+class PetriNetScene;
+class PetriPlace;
+class PetriTransition;
+class PetriArc;
+
+// Команды журнала отмены хранят только изменённые элементы и их
+// старые/новые значения, поэтому память пропорциональна изменению, а не сети.
+
+// Добавление позиции или перехода
+class AddNodeCommand : public QUndoCommand
+{
+public:
+    AddNodeCommand(PetriNetScene* scene, QGraphicsItem* node, QUndoCommand* parent = nullptr);
+    ~AddNodeCommand() override;
+
+    void undo() override;
+    void redo() override;
+
+private:
+    PetriNetScene* m_scene;
+    QGraphicsItem* m_node;
+    bool m_ownsNode{false}; // Элемент вне сцены и принадлежит команде
+};
+
+// Добавление дуги
+class AddArcCommand : public QUndoCommand
+{
+public:
+    AddArcCommand(PetriNetScene* scene, PetriArc* arc, QUndoCommand* parent = nullptr);
+    ~AddArcCommand() override;
+
+    void undo() override;
+    void redo() override;
+
+private:
+    PetriNetScene* m_scene;
+    PetriArc* m_arc;
+    bool m_ownsArc{false};
+};
+
+// Удаление набора элементов с каскадным удалением инцидентных дуг
+class RemoveItemsCommand : public QUndoCommand
+{
+public:
+    RemoveItemsCommand(PetriNetScene* scene, const QList<QGraphicsItem*>& items, QUndoCommand* parent = nullptr);
+    ~RemoveItemsCommand() override;
+
+    void undo() override;
+    void redo() override;
+
+    bool isEmpty() const;
+
+private:
+    PetriNetScene* m_scene;
+    QVector<QGraphicsItem*> m_nodes;
+    QVector<PetriArc*> m_arcs;
+    bool m_ownsItems{false};
+};
+
+// Групповое перемещение выделенных элементов
+class MoveItemsCommand : public QUndoCommand
+{
+public:
+    struct Move {
+        QGraphicsItem* item;
+        QPointF from;
+        QPointF to;
+    };
+
+    MoveItemsCommand(PetriNetScene* scene, const QVector<Move>& moves, QUndoCommand* parent = nullptr);
+
+    void undo() override;
+    void redo() override;
+
+private:
+    PetriNetScene* m_scene;
+    QVector<Move> m_moves;
+};
+
+// Изменение количества фишек
+class SetTokensCommand : public QUndoCommand
+{
+public:
+    SetTokensCommand(PetriNetScene* scene, PetriPlace* place, int tokens, QUndoCommand* parent = nullptr);
+
+    void undo() override;
+    void redo() override;
+
+    int id() const override;
+    bool mergeWith(const QUndoCommand* other) override;
+
+private:
+    PetriNetScene* m_scene;
+    PetriPlace* m_place;
+    int m_oldTokens;
+    int m_newTokens;
+};
+
+// Изменение веса дуги
+class SetWeightCommand : public QUndoCommand
+{
+public:
+    SetWeightCommand(PetriNetScene* scene, PetriArc* arc, int weight, QUndoCommand* parent = nullptr);
+
+    void undo() override;
+    void redo() override;
+
+private:
+    PetriNetScene* m_scene;
+    PetriArc* m_arc;
+    int m_oldWeight;
+    int m_newWeight;
+};
+
+class SetQueueModeCommand : public QUndoCommand
+{
+public:
+    SetQueueModeCommand(PetriNetScene* scene, PetriPlace* place, bool queue, QUndoCommand* parent = nullptr);
+
+    void undo() override;
+    void redo() override;
+
+private:
+    PetriNetScene* m_scene;
+    PetriPlace* m_place;
+    bool m_queue;
+};
+
+// Назначение перехода подстановкой страницы подсети; если задана
+// created, команда добавляет эту страницу в иерархию и при отмене убирает
+class SetSubnetCommand : public QUndoCommand
+{
+public:
+    SetSubnetCommand(PetriNetScene* scene, PetriTransition* transition, int subnet,
+                     const QHash<int, int>& ports, const SubnetPage& created = SubnetPage(),
+                     QUndoCommand* parent = nullptr);
+
+    void undo() override;
+    void redo() override;
+
+private:
+    PetriNetScene* m_scene;
+    PetriTransition* m_transition;
+    int m_oldSubnet;
+    QHash<int, int> m_oldPorts;
+    int m_newSubnet;
+    QHash<int, int> m_newPorts;
+    SubnetPage m_page;      // Снимок созданной страницы на время отмены
+    bool m_createsPage;
+};
+
+#endif // PETRICOMMANDS_H
@@ -1,5 +1,6 @@
 // petriarc.cpp
 #include "petriarc.h"
+#include "../../Core/petriprofiler.h"
 
 PetriArc::PetriArc(PetriPlace *place, PetriTransition *transition, bool fromPlace, int weight)
     : QGraphicsLineItem(),
@@ -25,8 +26,45 @@ void PetriArc::updatePosition()
     setLine(line);
 }
 
+PetriPlace* PetriArc::place() const
+{
+    return m_place;
+}
+
+PetriTransition* PetriArc::transition() const
+{
+    return m_transition;
+}
+
+bool PetriArc::fromPlace() const
+{
+    return _fromPlace;
+}
+
+void PetriArc::setWeight(int weight)
+{
+    m_weight = weight;
+    update();
+}
+
+int PetriArc::weight() const
+{
+    return m_weight;
+}
+
+void PetriArc::setId(int id)
+{
+    m_id = id;
+}
+
+int PetriArc::id() const
+{
+    return m_id;
+}
+
 void PetriArc::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
+    PETRI_PROFILE_SCOPE("paint.arc");
     QPointF start = line().p1();
     QPointF end = line().p2();
 
@@ -16,10 +16,22 @@ class PetriArc : public QObject, public QGraphicsLineItem
 {
     Q_OBJECT
 public:
+    enum { Type = UserType + 3 };
+    int type() const override { return Type; }
+
     explicit PetriArc(PetriPlace *place, PetriTransition *transition, bool fromPlace, int weight);
 
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
 
+    PetriPlace* place() const;
+    PetriTransition* transition() const;
+    bool fromPlace() const;
+
+    void setWeight(int weight);
+    int weight() const;
+
+    void setId(int id);
+    int id() const;
 
 public slots:
     void updatePosition();
@@ -27,8 +39,9 @@ public slots:
 private:
     QPointF calculateIntersection(const QPointF &point1, const QPointF &point2, const QGraphicsItem *item);
 
-    const PetriPlace* m_place;
-    const PetriTransition* m_transition;
+    PetriPlace* m_place;
+    PetriTransition* m_transition;
+    int m_id{-1};
     bool _fromPlace;
     int m_weight;
 
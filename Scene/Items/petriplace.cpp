@@ -1,5 +1,6 @@
 // petriplace.cpp
 #include "petriplace.h"
+#include "../../Core/petriprofiler.h"
 #include "qpainter.h"
 
 
@@ -18,6 +19,7 @@ PetriPlace::PetriPlace(QGraphicsItem *parent, QString label)
 
 void PetriPlace::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
+    PETRI_PROFILE_SCOPE("paint.place");
     QGraphicsEllipseItem::paint(painter, option, widget);
 
     // Рисуем разделение для режима очереди
@@ -26,6 +28,13 @@ void PetriPlace::paint(QPainter *painter, const QStyleOptionGraphicsItem *option
         painter->drawLine(-20, 0, 20, 0);
     }
 
+    // Порт подсети обводится пунктиром
+    if (m_port) {
+        painter->setPen(QPen(Qt::black, 1, Qt::DashLine));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawEllipse(rect().adjusted(4, 4, -4, -4));
+    }
+
     // Рисуем фишки
     if (m_tokens > 0) {
         if (m_tokens <= 7) {
@@ -64,6 +73,38 @@ QString PetriPlace::label() const
     return m_label;
 }
 
+void PetriPlace::setId(int id)
+{
+    m_id = id;
+}
+
+int PetriPlace::id() const
+{
+    return m_id;
+}
+
+void PetriPlace::setPort(bool port)
+{
+    m_port = port;
+    update();
+}
+
+bool PetriPlace::isPort() const
+{
+    return m_port;
+}
+
+void PetriPlace::setQueueMode(bool queue)
+{
+    m_queueMode = queue;
+    update();
+}
+
+bool PetriPlace::isQueueMode() const
+{
+    return m_queueMode;
+}
+
 QVariant PetriPlace::itemChange(GraphicsItemChange change, const QVariant &value)
 {
     if (change == QGraphicsItem::ItemPositionHasChanged) {
@@ -72,8 +113,17 @@ QVariant PetriPlace::itemChange(GraphicsItemChange change, const QVariant &value
     return QGraphicsEllipseItem::itemChange(change, value);
 }
 
-void PetriPlace::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event)
+void PetriPlace::addArc(PetriArc *arc)
 {
-    m_tokens++;
-    update();
+    m_arcs.append(arc);
+}
+
+void PetriPlace::removeArc(PetriArc *arc)
+{
+    m_arcs.removeOne(arc);
+}
+
+const QList<PetriArc*>& PetriPlace::arcs() const
+{
+    return m_arcs;
 }
@@ -6,10 +6,16 @@
 #include <QStyleOptionGraphicsItem>
 #include <QObject>
 
+class PetriArc;
+
 class PetriPlace : public QObject, public QGraphicsEllipseItem
 {
     Q_OBJECT
 public:
+    // Тип для qgraphicsitem_cast без dynamic_cast
+    enum { Type = UserType + 1 };
+    int type() const override { return Type; }
+
     explicit PetriPlace(QGraphicsItem *parent, QString label);
 
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
@@ -19,18 +25,34 @@ public:
 
     QString label() const;
 
-    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
+    void setId(int id);
+    int id() const;
 
+    // Порт страницы подсети
+    void setPort(bool port);
+    bool isPort() const;
 
-    void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event) override;
+    // Позиция-очередь: фишки извлекаются в порядке поступления
+    void setQueueMode(bool queue);
+    bool isQueueMode() const;
+
+    // Индекс смежности: дуги, инцидентные позиции
+    void addArc(PetriArc* arc);
+    void removeArc(PetriArc* arc);
+    const QList<PetriArc*>& arcs() const;
+
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
 
 signals:
     void positionChanged();
 private:
+    int m_id{-1};
     QString m_label{""};
     int m_tokens{0};
     bool m_queueMode{false};
+    bool m_port{false};
 
+    QList<PetriArc*> m_arcs;
 };
 
 #endif // PETRIPLACE_H
@@ -1,13 +1,15 @@
 // petritransition.cpp
 #include "petritransition.h"
+#include "../../Core/petriprofiler.h"
+#include "petriarc.h"
 #include "qpainter.h"
 
 
-PetriTransition::PetriTransition(QGraphicsItem *parent)
+PetriTransition::PetriTransition(QGraphicsItem *parent, QString label)
     : QGraphicsRectItem(-10, -40, 20, 80, parent),
     m_firingTime(0),
     m_priority(0),
-    m_label("t0")
+    m_label(label)
 {
     setFlag(QGraphicsItem::ItemIsMovable);
     setFlag(QGraphicsItem::ItemIsSelectable);
@@ -18,8 +20,17 @@ PetriTransition::PetriTransition(QGraphicsItem *parent)
 
 void PetriTransition::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
+    PETRI_PROFILE_SCOPE("paint.transition");
     QGraphicsRectItem::paint(painter, option, widget);
 
+    // Переход-подстановка рисуется с белой вставкой
+    if (m_subnet >= 0) {
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(Qt::white);
+        painter->drawRect(rect().adjusted(4, 12, -4, -12));
+        painter->setPen(QPen(Qt::black, 1));
+    }
+
     // Рисуем временные параметры
     if (m_firingTime > 0) {
         painter->setFont(QFont("Arial", 7));
@@ -50,10 +61,69 @@ QVariant PetriTransition::itemChange(GraphicsItemChange change, const QVariant &
     return QGraphicsRectItem::itemChange(change, value);
 }
 
-void PetriTransition::addPlace(PetriPlace * place, bool from)
+QString PetriTransition::label() const
+{
+    return m_label;
+}
+
+void PetriTransition::setId(int id)
+{
+    m_id = id;
+}
+
+int PetriTransition::id() const
+{
+    return m_id;
+}
+
+void PetriTransition::setSubnet(int subnet, const QHash<int, int> &ports)
+{
+    m_subnet = subnet;
+    m_ports = ports;
+    update();
+}
+
+int PetriTransition::subnet() const
+{
+    return m_subnet;
+}
+
+const QHash<int, int> &PetriTransition::ports() const
 {
-    if(from)
-        _fromPlacesList.append(place);
-    else
-        _toPlacesList.append(place);
+    return m_ports;
+}
+
+void PetriTransition::addArc(PetriArc *arc)
+{
+    m_arcs.append(arc);
+}
+
+void PetriTransition::removeArc(PetriArc *arc)
+{
+    m_arcs.removeOne(arc);
+}
+
+const QList<PetriArc*>& PetriTransition::arcs() const
+{
+    return m_arcs;
+}
+
+QList<PetriPlace*> PetriTransition::inputPlaces() const
+{
+    QList<PetriPlace*> places;
+    for (PetriArc* arc : m_arcs) {
+        if (arc->fromPlace())
+            places.append(arc->place());
+    }
+    return places;
+}
+
+QList<PetriPlace*> PetriTransition::outputPlaces() const
+{
+    QList<PetriPlace*> places;
+    for (PetriArc* arc : m_arcs) {
+        if (!arc->fromPlace())
+            places.append(arc->place());
+    }
+    return places;
 }
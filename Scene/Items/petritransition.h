@@ -8,28 +8,54 @@
 #include <QGraphicsSceneMouseEvent>
 #include <QPainter>
 #include <QDebug>
+#include <QHash>
 #include "petriplace.h"
 
+class PetriArc;
+
 class PetriTransition : public QObject, public QGraphicsRectItem
 {
     Q_OBJECT
 public:
-    explicit PetriTransition(QGraphicsItem *parent);
+    enum { Type = UserType + 2 };
+    int type() const override { return Type; }
+
+    explicit PetriTransition(QGraphicsItem *parent, QString label);
 
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
     QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
-    void addPlace(PetriPlace*, bool from);
+
+    QString label() const;
+
+    void setId(int id);
+    int id() const;
+
+    // Переход-подстановка: ссылка на страницу подсети и привязка её портов
+    void setSubnet(int subnet, const QHash<int, int>& ports);
+    int subnet() const;
+    const QHash<int, int>& ports() const;
+
+    // Индекс смежности: дуги, инцидентные переходу
+    void addArc(PetriArc* arc);
+    void removeArc(PetriArc* arc);
+    const QList<PetriArc*>& arcs() const;
+
+    // Входные и выходные позиции за O(степени)
+    QList<PetriPlace*> inputPlaces() const;
+    QList<PetriPlace*> outputPlaces() const;
 signals:
     void positionChanged();
 
 private:
+    int m_id{-1};
     int m_firingTime{0};
     int m_priority{0};
     QPair<int, int> m_timeInterval {0, 0};
     QString m_label;
+    int m_subnet{-1};
+    QHash<int, int> m_ports;
 
-    QList<PetriPlace*> _fromPlacesList;
-    QList<PetriPlace*> _toPlacesList;
+    QList<PetriArc*> m_arcs;
 };
 
 #endif // PETRITRANSITION_H
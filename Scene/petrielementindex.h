@@ -0,0 +1,57 @@
+#ifndef PETRIELEMENTINDEX_H
+#define PETRIELEMENTINDEX_H
+
+#include <QHash>
+#include <QList>
+
+// Список элементов одного типа с поиском по id за O(1).
+// Удаление переставляет последний элемент на место удалённого,
+// поэтому порядок списка не совпадает с порядком добавления.
+template <typename T>
+class PetriElementIndex
+{
+public:
+    void insert(T* item)
+    {
+        if (m_positions.contains(item->id()))
+            return;
+        m_positions.insert(item->id(), m_items.size());
+        m_items.append(item);
+    }
+
+    void remove(T* item)
+    {
+        auto it = m_positions.find(item->id());
+        if (it == m_positions.end() || m_items[it.value()] != item)
+            return;
+        const int index = it.value();
+        m_positions.erase(it);
+        T* last = m_items.takeLast();
+        if (last != item) {
+            m_items[index] = last;
+            m_positions[last->id()] = index;
+        }
+    }
+
+    T* value(int id) const
+    {
+        const int index = m_positions.value(id, -1);
+        return index < 0 ? nullptr : m_items[index];
+    }
+
+    bool contains(int id) const { return m_positions.contains(id); }
+    int size() const { return m_items.size(); }
+    const QList<T*>& items() const { return m_items; }
+
+    void clear()
+    {
+        m_items.clear();
+        m_positions.clear();
+    }
+
+private:
+    QList<T*> m_items;
+    QHash<int, int> m_positions; // id -> индекс в m_items
+};
+
+#endif // PETRIELEMENTINDEX_H
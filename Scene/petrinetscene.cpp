@@ -1,22 +1,49 @@
 // petrinetscene.cpp
 #include "petrinetscene.h"
+#include "Commands/petricommands.h"
+#include "../Core/petriprofiler.h"
 #include <QDialog>
 #include <QVBoxLayout>
 #include <QLabel>
 #include<QLineEdit>
 #include<QPushButton>
+#include <QSet>
+#include <QStringList>
+#include <algorithm>
+
+namespace {
+// Номер из метки вида "p12"; -1 для меток другого вида
+int labelNumber(const QString& label, QChar prefix)
+{
+    if (label.size() < 2 || label[0] != prefix)
+        return -1;
+    bool ok = false;
+    const int number = label.mid(1).toInt(&ok);
+    return ok ? number : -1;
+}
+}
 
 PetriNetScene::PetriNetScene(QObject *parent)
     : QGraphicsScene(parent),
     m_gridVisible(true),
     m_gridSize(20),
     m_gridColor(Qt::lightGray),
-    m_currentTool(Tool::ToolSelect)
+    m_currentTool(Tool::ToolSelect),
+    m_undoGroup(new QUndoGroup(this)),
+    m_undoStack(new QUndoStack(this))
 {
+    m_undoGroup->addStack(m_undoStack);
+    m_undoGroup->setActiveStack(m_undoStack);
+
     // Настройка сцены
     setSceneRect(-1000, -1000, 2000, 2000);
 }
 
+PetriNetScene::~PetriNetScene()
+{
+    dropPageStates();
+}
+
 void PetriNetScene::drawBackground(QPainter *painter, const QRectF &rect)
 {
     QGraphicsScene::drawBackground(painter, rect);
@@ -49,11 +76,11 @@ void PetriNetScene::mousePressEvent(QGraphicsSceneMouseEvent *event)
             addTransition(event->scenePos());
             break;
         case ToolArc:
-            if (PetriPlace* place = dynamic_cast<PetriPlace*>(item)) {
+            if (PetriPlace* place = qgraphicsitem_cast<PetriPlace*>(item)) {
                 m_tempArcStartPlace = place;
                 m_tempArcStartTransition = nullptr;
             }
-            else if (PetriTransition* transition = dynamic_cast<PetriTransition*>(item)) {
+            else if (PetriTransition* transition = qgraphicsitem_cast<PetriTransition*>(item)) {
                 m_tempArcStartTransition = transition;
                 m_tempArcStartPlace = nullptr;
             }
@@ -64,6 +91,12 @@ void PetriNetScene::mousePressEvent(QGraphicsSceneMouseEvent *event)
             break;
         default:
             QGraphicsScene::mousePressEvent(event);
+            // Запоминаем позиции выделенных узлов до перетаскивания
+            m_moveStartPositions.clear();
+            for (QGraphicsItem* selected : selectedItems()) {
+                if (nodeId(selected) >= 0)
+                    m_moveStartPositions.insert(selected, selected->pos());
+            }
         }
     }
     else if(event->button() == Qt::RightButton)
@@ -82,13 +115,16 @@ void PetriNetScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
     if (event->button() == Qt::LeftButton && m_currentTool == ToolArc) {
         QList<QGraphicsItem*> tmp = items(event->scenePos());
         QGraphicsItem* item = itemAt(event->scenePos(), QTransform());
-        removeItem(tempLine);
+        if (tempLine) {
+            removeItem(tempLine);
+            delete tempLine;
+        }
 
-        if (m_tempArcStartPlace && dynamic_cast<PetriTransition*>(item)) {
+        if (m_tempArcStartPlace && qgraphicsitem_cast<PetriTransition*>(item)) {
             // Создаем дугу от Place к Transition
             addArc(m_tempArcStartPlace, static_cast<PetriTransition*>(item), true, 1);
         }
-        else if (m_tempArcStartTransition && dynamic_cast<PetriPlace*>(item)) {
+        else if (m_tempArcStartTransition && qgraphicsitem_cast<PetriPlace*>(item)) {
             // Создаем дугу от Transition к Place
             addArc(static_cast<PetriPlace*>(item), m_tempArcStartTransition, false, 1);
         }
@@ -99,6 +135,18 @@ void PetriNetScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
         update();
     }
     QGraphicsScene::mouseReleaseEvent(event);
+
+    if (event->button() == Qt::LeftButton && !m_moveStartPositions.isEmpty()) {
+        // Все перемещённые за одно перетаскивание элементы — одна команда
+        QVector<MoveItemsCommand::Move> moves;
+        for (auto it = m_moveStartPositions.cbegin(); it != m_moveStartPositions.cend(); ++it) {
+            if (it.key()->pos() != it.value())
+                moves.append({it.key(), it.value(), it.key()->pos()});
+        }
+        m_moveStartPositions.clear();
+        if (!moves.isEmpty())
+            m_undoStack->push(new MoveItemsCommand(this, moves));
+    }
 }
 
 void PetriNetScene::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
@@ -115,20 +163,39 @@ void PetriNetScene::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
     QGraphicsScene::mouseMoveEvent(event);
 }
 
+void PetriNetScene::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event)
+{
+    QGraphicsItem* item = itemAt(event->scenePos(), QTransform());
+    if (PetriPlace* place = qgraphicsitem_cast<PetriPlace*>(item)) {
+        setTokens(place, place->tokens() + 1);
+        return;
+    }
+    if (PetriTransition* transition = qgraphicsitem_cast<PetriTransition*>(item)) {
+        if (transition->subnet() >= 0) {
+            openSubnet(transition);
+            return;
+        }
+    }
+    QGraphicsScene::mouseDoubleClickEvent(event);
+}
+
 void PetriNetScene::addPlace(const QPointF &pos)
 {
     PetriPlace *place = new PetriPlace(nullptr, "p" + QString::number(placesCount));
     placesCount++;
+    place->setId(m_nextId++);
     place->setPos(pos);
-    addItem(place);
+    m_undoStack->push(new AddNodeCommand(this, place));
     emit placeAdded(place);
 }
 
 void PetriNetScene::addTransition(const QPointF &pos)
 {
-    PetriTransition *transition = new PetriTransition(nullptr);
+    PetriTransition *transition = new PetriTransition(nullptr, "t" + QString::number(transitionsCount));
+    transitionsCount++;
+    transition->setId(m_nextId++);
     transition->setPos(pos);
-    addItem(transition);
+    m_undoStack->push(new AddNodeCommand(this, transition));
     emit transitionAdded(transition);
 }
 
@@ -137,12 +204,655 @@ void PetriNetScene::addArc(PetriPlace *place, PetriTransition *transition, bool
     if (!place || !transition) return;
 
     PetriArc *arc = new PetriArc(place, transition, fromPlace, weight);
-    transition->addPlace(place, fromPlace);
-    addItem(arc);
-    place->setParentItem(place);
+    arc->setId(m_nextId++);
+    m_undoStack->push(new AddArcCommand(this, arc));
     emit arcAdded(arc);
 }
 
+void PetriNetScene::removeItems(const QList<QGraphicsItem *> &items)
+{
+    RemoveItemsCommand* command = new RemoveItemsCommand(this, items);
+    if (command->isEmpty()) {
+        delete command;
+        return;
+    }
+    m_undoStack->push(command);
+}
+
+void PetriNetScene::setTokens(PetriPlace *place, int tokens)
+{
+    if (place->tokens() == tokens) return;
+    m_undoStack->push(new SetTokensCommand(this, place, tokens));
+}
+
+void PetriNetScene::setWeight(PetriArc *arc, int weight)
+{
+    if (arc->weight() == weight) return;
+    m_undoStack->push(new SetWeightCommand(this, arc, weight));
+}
+
+void PetriNetScene::setQueueMode(PetriPlace *place, bool queue)
+{
+    if (place->isQueueMode() == queue) return;
+    m_undoStack->push(new SetQueueModeCommand(this, place, queue));
+}
+
+void PetriNetScene::moveNodes(const QVector<QGraphicsItem *> &nodes, const QVector<QPointF> &from, const QVector<QPointF> &to)
+{
+    QVector<MoveItemsCommand::Move> moves;
+    moves.reserve(nodes.size());
+    for (int i = 0; i < nodes.size(); ++i) {
+        if (nodes[i] && from[i] != to[i])
+            moves.append({nodes[i], from[i], to[i]});
+    }
+    if (!moves.isEmpty())
+        m_undoStack->push(new MoveItemsCommand(this, moves));
+}
+
+PetriPlace *PetriNetScene::placeById(int id) const
+{
+    return m_places.value(id);
+}
+
+PetriTransition *PetriNetScene::transitionById(int id) const
+{
+    return m_transitions.value(id);
+}
+
+PetriArc *PetriNetScene::arcById(int id) const
+{
+    return m_arcs.value(id);
+}
+
+QGraphicsItem *PetriNetScene::nodeById(int id) const
+{
+    if (PetriPlace* place = m_places.value(id))
+        return place;
+    return m_transitions.value(id);
+}
+
+QGraphicsItem *PetriNetScene::nodeByLabel(const QString &label) const
+{
+    QGraphicsItem* result = nullptr;
+    for (auto it = m_nodesByLabel.find(label); it != m_nodesByLabel.end() && it.key() == label; ++it) {
+        if (!result || nodeId(it.value()) < nodeId(result))
+            result = it.value();
+    }
+    return result;
+}
+
+QList<QGraphicsItem *> PetriNetScene::nodesByLabel(const QString &label) const
+{
+    QList<QGraphicsItem*> nodes = m_nodesByLabel.values(label);
+    std::sort(nodes.begin(), nodes.end(), [](const QGraphicsItem* a, const QGraphicsItem* b) {
+        return nodeId(a) < nodeId(b);
+    });
+    return nodes;
+}
+
+const QList<PetriPlace *> &PetriNetScene::places() const
+{
+    return m_places.items();
+}
+
+const QList<PetriTransition *> &PetriNetScene::transitions() const
+{
+    return m_transitions.items();
+}
+
+const QList<PetriArc *> &PetriNetScene::arcs() const
+{
+    return m_arcs.items();
+}
+
+QList<QGraphicsItem *> PetriNetScene::preset(const QGraphicsItem *node) const
+{
+    QList<QGraphicsItem*> result;
+    if (const PetriPlace* place = qgraphicsitem_cast<const PetriPlace*>(node)) {
+        for (PetriArc* arc : place->arcs()) {
+            if (!arc->fromPlace())
+                result.append(arc->transition());
+        }
+    }
+    else if (const PetriTransition* transition = qgraphicsitem_cast<const PetriTransition*>(node)) {
+        for (PetriArc* arc : transition->arcs()) {
+            if (arc->fromPlace())
+                result.append(arc->place());
+        }
+    }
+    return result;
+}
+
+QList<QGraphicsItem *> PetriNetScene::postset(const QGraphicsItem *node) const
+{
+    QList<QGraphicsItem*> result;
+    if (const PetriPlace* place = qgraphicsitem_cast<const PetriPlace*>(node)) {
+        for (PetriArc* arc : place->arcs()) {
+            if (arc->fromPlace())
+                result.append(arc->transition());
+        }
+    }
+    else if (const PetriTransition* transition = qgraphicsitem_cast<const PetriTransition*>(node)) {
+        for (PetriArc* arc : transition->arcs()) {
+            if (!arc->fromPlace())
+                result.append(arc->place());
+        }
+    }
+    return result;
+}
+
+int PetriNetScene::nodeId(const QGraphicsItem *node)
+{
+    if (const PetriPlace* place = qgraphicsitem_cast<const PetriPlace*>(node))
+        return place->id();
+    if (const PetriTransition* transition = qgraphicsitem_cast<const PetriTransition*>(node))
+        return transition->id();
+    return -1;
+}
+
+QString PetriNetScene::nodeLabel(const QGraphicsItem *node)
+{
+    if (const PetriPlace* place = qgraphicsitem_cast<const PetriPlace*>(node))
+        return place->label();
+    if (const PetriTransition* transition = qgraphicsitem_cast<const PetriTransition*>(node))
+        return transition->label();
+    return QString();
+}
+
+void PetriNetScene::registerNode(QGraphicsItem *node)
+{
+    if (PetriPlace* place = qgraphicsitem_cast<PetriPlace*>(node))
+        m_places.insert(place);
+    else if (PetriTransition* transition = qgraphicsitem_cast<PetriTransition*>(node))
+        m_transitions.insert(transition);
+    m_nodesByLabel.insert(nodeLabel(node), node);
+}
+
+void PetriNetScene::unregisterNode(QGraphicsItem *node)
+{
+    if (PetriPlace* place = qgraphicsitem_cast<PetriPlace*>(node))
+        m_places.remove(place);
+    else if (PetriTransition* transition = qgraphicsitem_cast<PetriTransition*>(node))
+        m_transitions.remove(transition);
+
+    // Удаляется только эта пара: узлы с той же меткой остаются доступны
+    m_nodesByLabel.remove(nodeLabel(node), node);
+}
+
+void PetriNetScene::attachNode(QGraphicsItem *node)
+{
+    addItem(node);
+    registerNode(node);
+
+    QJsonObject change;
+    if (PetriPlace* place = qgraphicsitem_cast<PetriPlace*>(node)) {
+        change = PetriNetModel::placeToJson(placeData(place));
+        change["op"] = "addPlace";
+    }
+    else if (PetriTransition* transition = qgraphicsitem_cast<PetriTransition*>(node)) {
+        change = PetriNetModel::transitionToJson(transitionData(transition));
+        change["op"] = "addTransition";
+    }
+    recordChange(change);
+}
+
+void PetriNetScene::detachNode(QGraphicsItem *node)
+{
+    m_moveStartPositions.remove(node);
+    unregisterNode(node);
+    removeItem(node);
+    recordChange({{"op", "remove"}, {"id", nodeId(node)}});
+}
+
+void PetriNetScene::attachArc(PetriArc *arc)
+{
+    arc->place()->addArc(arc);
+    arc->transition()->addArc(arc);
+    m_arcs.insert(arc);
+    addItem(arc);
+    arc->updatePosition();
+
+    QJsonObject change = PetriNetModel::arcToJson(arcData(arc));
+    change["op"] = "addArc";
+    recordChange(change);
+}
+
+void PetriNetScene::detachArc(PetriArc *arc)
+{
+    arc->place()->removeArc(arc);
+    arc->transition()->removeArc(arc);
+    m_arcs.remove(arc);
+    removeItem(arc);
+    recordChange({{"op", "remove"}, {"id", arc->id()}});
+}
+
+void PetriNetScene::moveNode(QGraphicsItem *node, const QPointF &pos)
+{
+    node->setPos(pos);
+    recordChange({{"op", "move"}, {"id", nodeId(node)}, {"x", pos.x()}, {"y", pos.y()}});
+}
+
+void PetriNetScene::changeTokens(PetriPlace *place, int tokens)
+{
+    place->setTokens(tokens);
+    recordChange({{"op", "tokens"}, {"id", place->id()}, {"value", tokens}});
+}
+
+void PetriNetScene::changeWeight(PetriArc *arc, int weight)
+{
+    arc->setWeight(weight);
+    recordChange({{"op", "weight"}, {"id", arc->id()}, {"value", weight}});
+}
+
+void PetriNetScene::changeQueueMode(PetriPlace *place, bool queue)
+{
+    place->setQueueMode(queue);
+    recordChange({{"op", "queue"}, {"id", place->id()}, {"value", queue}});
+}
+
+void PetriNetScene::changeSubnet(PetriTransition *transition, int subnet, const QHash<int, int> &ports)
+{
+    transition->setSubnet(subnet, ports);
+    QJsonObject change = PetriNetModel::transitionToJson(transitionData(transition));
+    change["op"] = "subnet";
+    recordChange(change);
+}
+
+void PetriNetScene::insertSubnetPage(int id, const SubnetPage &page)
+{
+    m_subnets.insert(id, page);
+    emit hierarchyChanged();
+}
+
+SubnetPage PetriNetScene::removeSubnetPage(int id)
+{
+    // Страницу могли подставить переходы других страниц (их команды в
+    // других журналах) — тогда она остаётся, иначе файл сослался бы на
+    // отсутствующую подсеть
+    const SubnetPage page = m_subnets.value(id);
+    if (isSubnetReferenced(id))
+        return page;
+
+    // Страница без ссылок удаляется вместе с сохранённым состоянием;
+    // повтор загрузит её из снимка
+    if (m_pageStates.contains(id)) {
+        PageState state = m_pageStates.take(id);
+        delete state.undoStack;
+        qDeleteAll(state.items);
+    }
+    m_subnets.remove(id);
+    emit hierarchyChanged();
+    return page;
+}
+
+bool PetriNetScene::isSubnetReferenced(int id) const
+{
+    auto references = [id](const PetriNetModel& model) {
+        for (const TransitionData& transition : model.transitions) {
+            if (transition.subnet == id)
+                return true;
+        }
+        return false;
+    };
+
+    // Открытая страница — в элементах сцены, страницы на пути к ней — в
+    // m_parentPages; снимки в m_subnets актуальны для остальных страниц
+    for (PetriTransition* transition : m_transitions.items()) {
+        if (transition->subnet() == id)
+            return true;
+    }
+    for (const PetriNetModel& parent : m_parentPages) {
+        if (references(parent))
+            return true;
+    }
+    for (auto it = m_subnets.cbegin(); it != m_subnets.cend(); ++it) {
+        if (it.key() == id || m_pagePath.contains(it.key()) || !it.value().net)
+            continue;
+        if (references(*it.value().net))
+            return true;
+    }
+    return false;
+}
+
+void PetriNetScene::recordChange(QJsonObject change)
+{
+    if (currentPage() >= 0)
+        change["page"] = currentPage();
+    emit netChanged(change);
+}
+
+PlaceData PetriNetScene::placeData(const PetriPlace *place)
+{
+    PlaceData data{place->id(), place->label(), place->pos(), place->tokens()};
+    data.port = place->isPort();
+    data.queue = place->isQueueMode();
+    return data;
+}
+
+TransitionData PetriNetScene::transitionData(const PetriTransition *transition)
+{
+    TransitionData data{transition->id(), transition->label(), transition->pos()};
+    data.subnet = transition->subnet();
+    data.ports = transition->ports();
+    return data;
+}
+
+ArcData PetriNetScene::arcData(const PetriArc *arc)
+{
+    return {arc->id(), arc->place()->id(), arc->transition()->id(), arc->fromPlace(), arc->weight()};
+}
+
+PetriNetModel PetriNetScene::toModel() const
+{
+    PetriNetModel model;
+    model.places.reserve(m_places.size());
+    model.transitions.reserve(m_transitions.size());
+    model.arcs.reserve(m_arcs.size());
+    for (PetriPlace* place : m_places.items())
+        model.places.append(placeData(place));
+    for (PetriTransition* transition : m_transitions.items())
+        model.transitions.append(transitionData(transition));
+    for (PetriArc* arc : m_arcs.items())
+        model.arcs.append(arcData(arc));
+    model.nextId = m_nextId;
+    model.rebuildIndex();
+    return model;
+}
+
+void PetriNetScene::loadModel(const PetriNetModel &model)
+{
+    // Новый документ: история всех страниц сбрасывается
+    dropPageStates();
+    m_undoStack->clear();
+    m_subnets = model.subnets;
+    m_nextSubnet = m_subnets.isEmpty() ? 0 : m_subnets.lastKey() + 1;
+    m_pagePath.clear();
+    m_parentPages.clear();
+    loadPage(model);
+    emit hierarchyChanged();
+}
+
+void PetriNetScene::dropPageStates()
+{
+    // Журнал удаляется раньше элементов: его команды владеют только
+    // отсоединёнными элементами и к сохранённым не обращаются
+    for (PageState& state : m_pageStates) {
+        delete state.undoStack;
+        qDeleteAll(state.items);
+    }
+    m_pageStates.clear();
+}
+
+void PetriNetScene::clearPage()
+{
+    m_moveStartPositions.clear();
+    m_places.clear();
+    m_transitions.clear();
+    m_arcs.clear();
+    m_nodesByLabel.clear();
+    m_tempArcStartPlace = nullptr;
+    m_tempArcStartTransition = nullptr;
+    tempLine = nullptr;
+    clear();
+}
+
+void PetriNetScene::loadPage(const PetriNetModel &model)
+{
+    PETRI_PROFILE_SCOPE("scene.loadPage");
+    clearPage();
+
+    // Элементы создаются напрямую, минуя журнал отмены
+    for (const PlaceData& data : model.places) {
+        PetriPlace* place = new PetriPlace(nullptr, data.label);
+        place->setId(data.id);
+        place->setTokens(data.tokens);
+        place->setPort(data.port);
+        place->setQueueMode(data.queue);
+        place->setPos(data.pos);
+        addItem(place);
+        registerNode(place);
+    }
+    for (const TransitionData& data : model.transitions) {
+        PetriTransition* transition = new PetriTransition(nullptr, data.label);
+        transition->setId(data.id);
+        transition->setSubnet(data.subnet, data.ports);
+        transition->setPos(data.pos);
+        addItem(transition);
+        registerNode(transition);
+    }
+    for (const ArcData& data : model.arcs) {
+        PetriPlace* place = m_places.value(data.place);
+        PetriTransition* transition = m_transitions.value(data.transition);
+        if (!place || !transition) continue;
+        PetriArc* arc = new PetriArc(place, transition, data.fromPlace, data.weight);
+        arc->setId(data.id);
+        place->addArc(arc);
+        transition->addArc(arc);
+        m_arcs.insert(arc);
+        addItem(arc);
+    }
+
+    // Счётчики меток продолжают нумерацию загруженных элементов
+    placesCount = 0;
+    for (const PlaceData& data : model.places)
+        placesCount = qMax(placesCount, labelNumber(data.label, 'p') + 1);
+    transitionsCount = 0;
+    for (const TransitionData& data : model.transitions)
+        transitionsCount = qMax(transitionsCount, labelNumber(data.label, 't') + 1);
+    m_nextId = model.nextId;
+    update();
+}
+
+void PetriNetScene::leavePage()
+{
+    // Страница без истории при возврате просто загружается из модели
+    if (m_undoStack->count() == 0)
+        return;
+
+    if (tempLine) {
+        removeItem(tempLine);
+        delete tempLine;
+        tempLine = nullptr;
+    }
+    m_tempArcStartPlace = nullptr;
+    m_tempArcStartTransition = nullptr;
+    m_moveStartPositions.clear();
+
+    PageState state;
+    for (QGraphicsItem* item : items()) {
+        if (!item->parentItem())
+            state.items.append(item);
+    }
+    for (QGraphicsItem* item : state.items)
+        removeItem(item);
+    state.places = m_places;
+    state.transitions = m_transitions;
+    state.arcs = m_arcs;
+    state.nodesByLabel = m_nodesByLabel;
+    state.placesCount = placesCount;
+    state.transitionsCount = transitionsCount;
+    state.nextId = m_nextId;
+    state.undoStack = m_undoStack;
+    m_pageStates.insert(currentPage(), state);
+
+    m_places.clear();
+    m_transitions.clear();
+    m_arcs.clear();
+    m_nodesByLabel.clear();
+    m_undoStack = new QUndoStack(this);
+    m_undoGroup->addStack(m_undoStack);
+    m_undoGroup->setActiveStack(m_undoStack);
+}
+
+void PetriNetScene::enterPage(const PetriNetModel &model)
+{
+    const auto it = m_pageStates.find(currentPage());
+    if (it == m_pageStates.end()) {
+        loadPage(model);
+        return;
+    }
+
+    // Возврат сохранённых элементов вместе с их журналом
+    const PageState state = it.value();
+    m_pageStates.erase(it);
+    clearPage();
+    for (QGraphicsItem* item : state.items)
+        addItem(item);
+    m_places = state.places;
+    m_transitions = state.transitions;
+    m_arcs = state.arcs;
+    m_nodesByLabel = state.nodesByLabel;
+    placesCount = state.placesCount;
+    transitionsCount = state.transitionsCount;
+    m_nextId = state.nextId;
+
+    delete m_undoStack;     // Пустой журнал уходящей страницы
+    m_undoStack = state.undoStack;
+    m_undoGroup->setActiveStack(m_undoStack);
+    update();
+}
+
+PetriNetModel PetriNetScene::documentModel() const
+{
+    // Все страницы, кроме открытой, уже сохранены в m_subnets
+    QMap<int, SubnetPage> subnets = m_subnets;
+    PetriNetModel root = toModel();
+    if (currentPage() >= 0) {
+        subnets[currentPage()].net = QSharedPointer<PetriNetModel>::create(root);
+        root = m_parentPages.first();
+    }
+    root.subnets = subnets;
+    return root;
+}
+
+const QMap<int, SubnetPage> &PetriNetScene::subnets() const
+{
+    return m_subnets;
+}
+
+int PetriNetScene::currentPage() const
+{
+    return m_pagePath.isEmpty() ? -1 : m_pagePath.last();
+}
+
+QString PetriNetScene::currentPagePath() const
+{
+    QStringList names;
+    for (int page : m_pagePath)
+        names.append(m_subnets.value(page).name);
+    return names.join("/");
+}
+
+void PetriNetScene::makeSubnet(PetriTransition *transition)
+{
+    if (transition->subnet() >= 0) return;
+
+    // Страница повторяет поведение перехода: порты — копии его позиций,
+    // внутренний переход соединён с ними дугами тех же весов
+    PetriNetModel page;
+    QHash<PetriPlace*, int> portIds;
+    QHash<int, int> bindings;
+    int inputs = 0;
+    int outputs = 0;
+    for (PetriArc* arc : transition->arcs()) {
+        PetriPlace* place = arc->place();
+        if (portIds.contains(place)) continue;
+        PlaceData port;
+        port.id = page.nextId++;
+        port.label = place->label();
+        port.port = true;
+        port.pos = arc->fromPlace() ? QPointF(-200, 100 * inputs++) : QPointF(200, 100 * outputs++);
+        page.places.append(port);
+        portIds.insert(place, port.id);
+        bindings.insert(port.id, place->id());
+    }
+
+    TransitionData inner;
+    inner.id = page.nextId++;
+    inner.label = transition->label();
+    page.transitions.append(inner);
+
+    for (PetriArc* arc : transition->arcs())
+        page.arcs.append({page.nextId++, portIds.value(arc->place()), inner.id, arc->fromPlace(), arc->weight()});
+    page.rebuildIndex();
+
+    // Страница добавляется командой, чтобы отмена убирала её из иерархии
+    // id не переиспользуются: отменённую страницу может вернуть повтор
+    const int id = qMax(m_nextSubnet, m_subnets.isEmpty() ? 0 : m_subnets.lastKey() + 1);
+    m_nextSubnet = id + 1;
+    const SubnetPage created{QString("subnet%1").arg(id), QSharedPointer<PetriNetModel>::create(page)};
+    m_undoStack->push(new SetSubnetCommand(this, transition, id, bindings, created));
+}
+
+void PetriNetScene::instantiateSubnet(PetriTransition *transition, int subnet)
+{
+    const SubnetPage page = m_subnets.value(subnet);
+    if (!page.net || transition->subnet() == subnet) return;
+    m_undoStack->push(new SetSubnetCommand(this, transition, subnet, bindPorts(transition, *page.net)));
+}
+
+QHash<int, int> PetriNetScene::bindPorts(PetriTransition *transition, const PetriNetModel &page) const
+{
+    // Порт входной, если из него выходят дуги страницы
+    QSet<int> inputPorts;
+    for (const ArcData& arc : page.arcs) {
+        if (arc.fromPlace)
+            inputPorts.insert(arc.place);
+    }
+
+    QHash<int, int> bindings;
+    auto bind = [&](bool input, QList<PetriPlace*> outer) {
+        QList<const PlaceData*> ports;
+        for (const PlaceData& place : page.places) {
+            if (place.port && inputPorts.contains(place.id) == input)
+                ports.append(&place);
+        }
+        // Сначала по совпадению меток, затем оставшиеся по порядку
+        for (int i = ports.size() - 1; i >= 0; --i) {
+            for (int j = 0; j < outer.size(); ++j) {
+                if (outer[j]->label() == ports[i]->label) {
+                    bindings.insert(ports[i]->id, outer.takeAt(j)->id());
+                    ports.removeAt(i);
+                    break;
+                }
+            }
+        }
+        for (int i = 0; i < ports.size() && i < outer.size(); ++i)
+            bindings.insert(ports[i]->id, outer[i]->id());
+    };
+    bind(true, transition->inputPlaces());
+    bind(false, transition->outputPlaces());
+    return bindings;
+}
+
+void PetriNetScene::openSubnet(PetriTransition *transition)
+{
+    const int subnet = transition->subnet();
+    const SubnetPage page = m_subnets.value(subnet);
+    if (!page.net || m_pagePath.contains(subnet)) return;
+
+    PetriNetModel parent = toModel();
+    if (currentPage() >= 0)
+        m_subnets[currentPage()].net = QSharedPointer<PetriNetModel>::create(parent);
+    leavePage();
+    m_parentPages.append(parent);
+    m_pagePath.append(subnet);
+    enterPage(*page.net);
+    emit hierarchyChanged();
+}
+
+void PetriNetScene::closeSubnet()
+{
+    if (m_pagePath.isEmpty()) return;
+
+    // Новая копия страницы: снимки, разделяющие старую, не меняются
+    m_subnets[m_pagePath.last()].net = QSharedPointer<PetriNetModel>::create(toModel());
+    leavePage();
+    m_pagePath.removeLast();
+    enterPage(m_parentPages.takeLast());
+    emit hierarchyChanged();
+}
+
 void PetriNetScene::showContextMenu(const QPointF &pos, QGraphicsItem* item)
 {
     if(!item)
@@ -152,22 +862,53 @@ void PetriNetScene::showContextMenu(const QPointF &pos, QGraphicsItem* item)
     // Создаем действия меню
     QAction *action1 = contextMenu.addAction("Удалить");
     QAction *action2;
-    PetriPlace* place = dynamic_cast<PetriPlace*>(item);
+    PetriPlace* place = qgraphicsitem_cast<PetriPlace*>(item);
     if (place)
     {
         action2 = contextMenu.addAction("Изменить количество фишек");
         connect(action2, &QAction::triggered, this, [place, this](){
             onTokensEdit(place);
         });
+        QAction* queueAction = contextMenu.addAction("Очередь (FIFO)");
+        queueAction->setCheckable(true);
+        queueAction->setChecked(place->isQueueMode());
+        connect(queueAction, &QAction::toggled, this, [place, this](bool checked){
+            setQueueMode(place, checked);
+        });
     }
-    PetriArc* arc = dynamic_cast<PetriArc*>(item);
+    PetriTransition* transition = qgraphicsitem_cast<PetriTransition*>(item);
+    if (transition)
+    {
+        if (transition->subnet() >= 0) {
+            action2 = contextMenu.addAction("Открыть подсеть");
+            connect(action2, &QAction::triggered, this, [transition, this](){
+                openSubnet(transition);
+            });
+        } else {
+            action2 = contextMenu.addAction("Сделать подсетью");
+            connect(action2, &QAction::triggered, this, [transition, this](){
+                makeSubnet(transition);
+            });
+        }
+        if (!m_subnets.isEmpty()) {
+            QMenu* instanceMenu = contextMenu.addMenu("Экземпляр подсети");
+            for (auto it = m_subnets.cbegin(); it != m_subnets.cend(); ++it) {
+                const int subnet = it.key();
+                // Страница не может содержать экземпляр самой себя
+                if (m_pagePath.contains(subnet)) continue;
+                QAction* instanceAction = instanceMenu->addAction(it.value().name);
+                connect(instanceAction, &QAction::triggered, this, [transition, subnet, this](){
+                    instantiateSubnet(transition, subnet);
+                });
+            }
+        }
+    }
+    PetriArc* arc = qgraphicsitem_cast<PetriArc*>(item);
     if (arc)
     {
-        //TODO
-        //Сделать аналогично изменению фишек(tokens) у мест(place) изменение веса(weight) у стрелок(arc)
-        action2 = contextMenu.addAction("Изменить количество стрелок");
-        connect(action2, &QAction::triggered, this, [place, this](){
-            onTokensEdit(place);
+        action2 = contextMenu.addAction("Изменить вес дуги");
+        connect(action2, &QAction::triggered, this, [arc, this](){
+            onWeightEdit(arc);
         });
     }
     contextMenu.addSeparator();
@@ -175,7 +916,9 @@ void PetriNetScene::showContextMenu(const QPointF &pos, QGraphicsItem* item)
 
     // Подключаем действия к слотам
     connect(action1, &QAction::triggered, this, [item, this](){
-        removeItem(item);
+        // Если элемент входит в выделение — удаляем всё выделение
+        QList<QGraphicsItem*> toRemove = item->isSelected() ? selectedItems() : QList<QGraphicsItem*>{item};
+        removeItems(toRemove);
         update();
     });
     // connect(action3, &QAction::triggered, qApp, &QApplication::quit);
@@ -237,8 +980,43 @@ void PetriNetScene::onTokensEdit(PetriPlace* item)
     // Показываем диалог
     if (dialog.exec() == QDialog::Accepted) {
         int newTokens = intEdit->text().toInt();
-        item->setTokens(newTokens);
+        setTokens(item, newTokens);
         update();
     }
 
 }
+
+void PetriNetScene::onWeightEdit(PetriArc* item)
+{
+    QDialog dialog;
+    dialog.setWindowTitle("Ввод данных");
+    dialog.resize(100, 70);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout(&dialog);
+
+    QLabel *intLabel = new QLabel("Вес дуги: ");
+    QLineEdit *intEdit = new QLineEdit();
+    QIntValidator* intVld = new QIntValidator(intEdit);
+    intVld->setRange(1, 100);
+    intEdit->setValidator(intVld);
+    intEdit->setText(QString::number(item->weight()));
+    mainLayout->addWidget(intLabel);
+    mainLayout->addWidget(intEdit);
+
+    // Кнопки
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    QPushButton *okButton = new QPushButton("OK");
+    QPushButton *cancelButton = new QPushButton("Отмена");
+    buttonLayout->addWidget(okButton);
+    buttonLayout->addWidget(cancelButton);
+    mainLayout->addLayout(buttonLayout);
+
+    // Обработчики
+    QObject::connect(okButton, &QPushButton::clicked, &dialog, &QDialog::accept);
+    QObject::connect(cancelButton, &QPushButton::clicked, &dialog, &QDialog::reject);
+
+    if (dialog.exec() == QDialog::Accepted) {
+        setWeight(item, qMax(1, intEdit->text().toInt()));
+        update();
+    }
+}
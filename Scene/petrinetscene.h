@@ -10,10 +10,15 @@
 #include <QMenuBar>
 #include <QTreeWidget>
 #include <QActionGroup>
+#include <QUndoGroup>
+#include <QUndoStack>
+#include <QHash>
 
 #include "Items/petriplace.h"
 #include "Items/petritransition.h"
 #include "Items/petriarc.h"
+#include "petrielementindex.h"
+#include "../Core/petrinetmodel.h"
 
 class PetriNetScene : public QGraphicsScene
 {
@@ -27,17 +32,73 @@ public:
     };
 
     explicit PetriNetScene(QObject *parent = nullptr);
+    ~PetriNetScene() override;
 
     void drawBackground(QPainter *painter, const QRectF &rect) override;
 
     void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
     void mouseReleaseEvent(QGraphicsSceneMouseEvent* event) override;
     void mouseMoveEvent(QGraphicsSceneMouseEvent* event) override;
+    void mouseDoubleClickEvent(QGraphicsSceneMouseEvent* event) override;
 
     void addPlace(const QPointF &pos);
     void addTransition(const QPointF &pos);
     void addArc(PetriPlace *place, PetriTransition *transition, bool isInhibitor, int weight);
 
+    void removeItems(const QList<QGraphicsItem*>& items);
+    void setTokens(PetriPlace* place, int tokens);
+    void setWeight(PetriArc* arc, int weight);
+    void setQueueMode(PetriPlace* place, bool queue);
+    // Групповое перемещение одной командой (например, после авто-раскладки)
+    void moveNodes(const QVector<QGraphicsItem*>& nodes, const QVector<QPointF>& from, const QVector<QPointF>& to);
+
+    // Реестр элементов открытой страницы: поиск по id и метке за O(1)
+    PetriPlace* placeById(int id) const;
+    PetriTransition* transitionById(int id) const;
+    PetriArc* arcById(int id) const;
+    QGraphicsItem* nodeById(int id) const;
+    // Метки в старых файлах не уникальны (все переходы были "t0"):
+    // nodeByLabel возвращает узел с наименьшим id, nodesByLabel — все по id
+    QGraphicsItem* nodeByLabel(const QString& label) const;
+    QList<QGraphicsItem*> nodesByLabel(const QString& label) const;
+    const QList<PetriPlace*>& places() const;
+    const QList<PetriTransition*>& transitions() const;
+    const QList<PetriArc*>& arcs() const;
+
+    // Входное и выходное множества узла за O(степени)
+    QList<QGraphicsItem*> preset(const QGraphicsItem* node) const;
+    QList<QGraphicsItem*> postset(const QGraphicsItem* node) const;
+
+    static int nodeId(const QGraphicsItem* node);
+    static QString nodeLabel(const QGraphicsItem* node);
+
+    // Низкоуровневые операции без записи в журнал (используются командами)
+    void attachNode(QGraphicsItem* node);
+    void detachNode(QGraphicsItem* node);
+    void attachArc(PetriArc* arc);
+    void detachArc(PetriArc* arc);
+    void moveNode(QGraphicsItem* node, const QPointF& pos);
+    void changeTokens(PetriPlace* place, int tokens);
+    void changeWeight(PetriArc* arc, int weight);
+    void changeQueueMode(PetriPlace* place, bool queue);
+    void changeSubnet(PetriTransition* transition, int subnet, const QHash<int, int>& ports);
+    void insertSubnetPage(int id, const SubnetPage& page);
+    SubnetPage removeSubnetPage(int id);
+
+    // Снимок открытой страницы и загрузка документа (журналы отмены очищаются)
+    PetriNetModel toModel() const;
+    void loadModel(const PetriNetModel& model);
+
+    // Иерархия: страницы подсетей материализуются только при открытии
+    PetriNetModel documentModel() const;
+    const QMap<int, SubnetPage>& subnets() const;
+    int currentPage() const;
+    QString currentPagePath() const;
+    void makeSubnet(PetriTransition* transition);
+    void instantiateSubnet(PetriTransition* transition, int subnet);
+    void openSubnet(PetriTransition* transition);
+    void closeSubnet();
+
     void showContextMenu(const QPointF &pos, QGraphicsItem* item);
 
     void setCurrentTool(Tool tool);
@@ -50,17 +111,75 @@ public:
     PetriPlace* m_tempArcStartPlace{nullptr};
     PetriTransition* m_tempArcStartTransition{nullptr};
 
-    QGraphicsLineItem* tempLine;
+    QGraphicsLineItem* tempLine{nullptr};
 
     int placesCount{0};
+    int transitionsCount{0};
+    int m_nextId{0};
+
+    // У каждой страницы свой журнал; активен журнал открытой страницы
+    QUndoGroup* m_undoGroup;
+    QUndoStack* m_undoStack;
 
 protected slots:
     void onTokensEdit(PetriPlace* item);
+    void onWeightEdit(PetriArc* item);
+
+private:
+    // Страница с непустым журналом, сохранённая при уходе с неё: команды
+    // журнала ссылаются на её элементы, поэтому те не пересоздаются
+    struct PageState {
+        QList<QGraphicsItem*> items;
+        PetriElementIndex<PetriPlace> places;
+        PetriElementIndex<PetriTransition> transitions;
+        PetriElementIndex<PetriArc> arcs;
+        QMultiHash<QString, QGraphicsItem*> nodesByLabel;
+        int placesCount{0};
+        int transitionsCount{0};
+        int nextId{0};
+        QUndoStack* undoStack{nullptr};
+    };
+
+    void clearPage();
+    void loadPage(const PetriNetModel& model);
+    void leavePage();
+    void enterPage(const PetriNetModel& model);
+    void dropPageStates();
+    void recordChange(QJsonObject change);
+    QHash<int, int> bindPorts(PetriTransition* transition, const PetriNetModel& page) const;
+    bool isSubnetReferenced(int id) const;
+
+    static PlaceData placeData(const PetriPlace* place);
+    static TransitionData transitionData(const PetriTransition* transition);
+    static ArcData arcData(const PetriArc* arc);
+
+    void registerNode(QGraphicsItem* node);
+    void unregisterNode(QGraphicsItem* node);
+
+    PetriElementIndex<PetriPlace> m_places;
+    PetriElementIndex<PetriTransition> m_transitions;
+    PetriElementIndex<PetriArc> m_arcs;
+    QMultiHash<QString, QGraphicsItem*> m_nodesByLabel;
+
+    // Начальные позиции перемещаемых элементов для групповой команды
+    QHash<QGraphicsItem*, QPointF> m_moveStartPositions;
+
+    // Страницы документа; открытая страница хранится в элементах сцены
+    QMap<int, SubnetPage> m_subnets;
+    QVector<int> m_pagePath;               // Путь открытых страниц от корня
+    QVector<PetriNetModel> m_parentPages;  // m_parentPages[0] — корневая сеть
+    QHash<int, PageState> m_pageStates;    // Ключ — id страницы, -1 — корень
+    int m_nextSubnet{0};
 
 signals:
     void transitionAdded(PetriTransition* transition);
     void arcAdded(PetriArc* arc);
     void placeAdded(PetriPlace* place);
+
+    // Запись журнала изменений в формате PetriNetModel::applyChange
+    void netChanged(const QJsonObject& change);
+    // Открыта другая страница или добавлена страница подсети
+    void hierarchyChanged();
 };
 
 #endif // PETRINETSCENE_H
@@ -0,0 +1,16 @@
+# Графическая сцена редактора
+
+SOURCES += \
+    $$PWD/Items/petriarc.cpp \
+    $$PWD/Commands/petricommands.cpp \
+    $$PWD/petrinetscene.cpp \
+    $$PWD/Items/petriplace.cpp \
+    $$PWD/Items/petritransition.cpp
+
+HEADERS += \
+    $$PWD/Items/petriarc.h \
+    $$PWD/Commands/petricommands.h \
+    $$PWD/petrielementindex.h \
+    $$PWD/petrinetscene.h \
+    $$PWD/Items/petriplace.h \
+    $$PWD/Items/petritransition.h
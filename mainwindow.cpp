@@ -1,6 +1,10 @@
 // mainwindow.cpp
 #include "mainwindow.h"
 
+#include <QtConcurrent/QtConcurrent>
+#include <QStandardPaths>
+#include <QDir>
+#include <QVBoxLayout>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -15,6 +19,15 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_scene, &PetriNetScene::transitionAdded, this, &MainWindow::onTransitionAdded);
     connect(m_scene, &PetriNetScene::arcAdded, this, &MainWindow::onArcAdded);
 
+    m_layoutRunner = new LayoutRunner(this);
+    connect(m_layoutRunner, &LayoutRunner::positionsUpdated, this, &MainWindow::onLayoutFrame);
+    connect(m_layoutRunner, &LayoutRunner::layoutFinished, this, &MainWindow::onLayoutFinished);
+    connect(m_scene, &PetriNetScene::hierarchyChanged, this, [this]() {
+        m_layoutRunner->cancel();
+        const QString path = m_scene->currentPagePath();
+        setWindowTitle(path.isEmpty() ? "Petri Net Editor" : "Petri Net Editor - " + path);
+    });
+
     // Создание представления
     m_view = new QGraphicsView(m_scene, this);
     setCentralWidget(m_view);
@@ -28,13 +41,47 @@ MainWindow::MainWindow(QWidget *parent)
     // Создание меню
     createMenus();
 
+    // Автосохранение и восстановление после сбоя
+    createAutoSaver();
+    connect(&m_saveWatcher, &QFutureWatcher<QString>::finished, this, &MainWindow::onSaveFinished);
+
     // Статус бар
-    statusBar()->showMessage("Ready");
+    if (statusBar()->currentMessage().isEmpty())
+        statusBar()->showMessage("Ready");
 }
 
 MainWindow::~MainWindow()
 {
+    m_saveWatcher.waitForFinished();
+    delete m_layoutRunner;
+    // Штатное закрытие: данные для восстановления больше не нужны
+    m_autoSaver->discard();
+}
+
+void MainWindow::createAutoSaver()
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    m_autoSaver = new AutoSaver(dir + "/recovery", this);
+
+    if (m_autoSaver->hasRecoveryData()) {
+        PetriNetModel model;
+        QString error;
+        if (m_autoSaver->recover(&model, &error)) {
+            m_scene->loadModel(model);
+            statusBar()->showMessage("Recovered unsaved changes", 5000);
+        } else {
+            statusBar()->showMessage("Could not recover autosave: " + error, 5000);
+        }
+    }
 
+    m_autoSaver->setSnapshotProvider([this]() { return m_scene->documentModel(); });
+    connect(m_scene, &PetriNetScene::netChanged, m_autoSaver, &AutoSaver::recordChange);
+    // Смена страницы или новая страница подсети — полный снимок
+    connect(m_scene, &PetriNetScene::hierarchyChanged, m_autoSaver, &AutoSaver::compact);
+    connect(m_autoSaver, &AutoSaver::saveFailed, this, [this](const QString& error) {
+        statusBar()->showMessage("Autosave failed: " + error, 5000);
+    });
 }
 
 void MainWindow::createToolBar()
@@ -82,6 +129,90 @@ void MainWindow::createDockWidgets()
     // m_simulationWidget = new SimulationWidget(m_simulationDock);
     // m_simulationDock->setWidget(m_simulationWidget);
     // addDockWidget(Qt::LeftDockWidgetArea, m_simulationDock);
+
+    // Панель статистики профилирования
+    createStatisticsDock();
+}
+
+void MainWindow::createStatisticsDock()
+{
+    m_statsDock = new QDockWidget("Statistics", this);
+    QWidget* panel = new QWidget(m_statsDock);
+    QVBoxLayout* layout = new QVBoxLayout(panel);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    QToolBar* toolBar = new QToolBar(panel);
+    QAction* traceAction = toolBar->addAction("Record trace");
+    traceAction->setCheckable(true);
+    connect(traceAction, &QAction::toggled, [](bool checked) { PetriProfiler::setTracing(checked); });
+    QAction* resetAction = toolBar->addAction("Reset");
+    connect(resetAction, &QAction::triggered, [this]() {
+        PetriProfiler::reset();
+        updateStatistics();
+    });
+    QAction* exportAction = toolBar->addAction("Export trace...");
+    connect(exportAction, &QAction::triggered, this, &MainWindow::exportTrace);
+    layout->addWidget(toolBar);
+
+    m_statsView = new QTreeWidget(panel);
+    m_statsView->setRootIsDecorated(false);
+    m_statsView->setHeaderLabels({"Name", "Calls", "Total, ms", "Avg, us", "Max, us"});
+    layout->addWidget(m_statsView);
+
+    m_statsDock->setWidget(panel);
+    addDockWidget(Qt::RightDockWidgetArea, m_statsDock);
+
+    // Без PETRI_PROFILING макросы пустые и собирать нечего
+    if (!PetriProfiler::isCompiledIn()) {
+        toolBar->setEnabled(false);
+        new QTreeWidgetItem(m_statsView, {"Built without profiling (qmake CONFIG+=profiling)"});
+        m_statsTimer = nullptr;
+        return;
+    }
+
+    // Обновление только пока панель видна
+    m_statsTimer = new QTimer(this);
+    m_statsTimer->setInterval(500);
+    connect(m_statsTimer, &QTimer::timeout, this, &MainWindow::updateStatistics);
+    connect(m_statsDock, &QDockWidget::visibilityChanged, [this](bool visible) {
+        if (visible) {
+            updateStatistics();
+            m_statsTimer->start();
+        } else {
+            m_statsTimer->stop();
+        }
+    });
+}
+
+void MainWindow::updateStatistics()
+{
+    const QVector<PetriProfiler::SiteStats> stats = PetriProfiler::snapshot();
+    while (m_statsView->topLevelItemCount() < stats.size())
+        new QTreeWidgetItem(m_statsView);
+
+    for (int i = 0; i < stats.size(); ++i) {
+        const PetriProfiler::SiteStats& site = stats[i];
+        QTreeWidgetItem* item = m_statsView->topLevelItem(i);
+        item->setText(0, site.name);
+        item->setText(1, QString::number(site.calls));
+        // Для счётчиков время не измеряется
+        const bool timed = site.nanos > 0;
+        item->setText(2, timed ? QString::number(site.nanos / 1e6, 'f', 2) : QString());
+        item->setText(3, timed && site.calls > 0 ? QString::number(site.nanos / 1e3 / site.calls, 'f', 2) : QString());
+        item->setText(4, timed ? QString::number(site.maxNanos / 1e3, 'f', 2) : QString());
+    }
+}
+
+void MainWindow::exportTrace()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "Export Trace", "", "Chrome Trace Files (*.json)");
+    if (fileName.isEmpty()) return;
+
+    QString error;
+    if (PetriProfiler::exportChromeTrace(fileName, &error))
+        statusBar()->showMessage(QString("Exported %1 trace events").arg(PetriProfiler::traceEventCount()), 2000);
+    else
+        statusBar()->showMessage("Could not export trace: " + error, 2000);
 }
 
 void MainWindow::createMenus()
@@ -103,11 +234,54 @@ void MainWindow::createMenus()
     QAction *exportAction = new QAction("Export to JSON...", this);
     connect(exportAction, &QAction::triggered, this, &MainWindow::exportToJson);
     fileMenu->addAction(exportAction);
+
+    QMenu *editMenu = menuBar()->addMenu("Edit");
+
+    QAction *undoAction = m_scene->m_undoGroup->createUndoAction(this, "Undo");
+    undoAction->setShortcut(QKeySequence::Undo);
+    editMenu->addAction(undoAction);
+
+    QAction *redoAction = m_scene->m_undoGroup->createRedoAction(this, "Redo");
+    redoAction->setShortcut(QKeySequence::Redo);
+    editMenu->addAction(redoAction);
+
+    QAction *deleteAction = new QAction("Delete", this);
+    deleteAction->setShortcut(QKeySequence::Delete);
+    connect(deleteAction, &QAction::triggered, [this]() { m_scene->removeItems(m_scene->selectedItems()); });
+    editMenu->addAction(deleteAction);
+
+    QMenu *subnetMenu = menuBar()->addMenu("Subnet");
+
+    QAction *upAction = new QAction("Up to parent", this);
+    upAction->setShortcut(QKeySequence(Qt::ALT | Qt::Key_Up));
+    connect(upAction, &QAction::triggered, [this]() { m_scene->closeSubnet(); });
+    subnetMenu->addAction(upAction);
+
+    QMenu *layoutMenu = menuBar()->addMenu("Layout");
+
+    QAction *forceAction = new QAction("Force-directed", this);
+    connect(forceAction, &QAction::triggered, [this]() { runLayout(LayoutOptions::ForceDirected); });
+    layoutMenu->addAction(forceAction);
+
+    QAction *layeredAction = new QAction("Layered", this);
+    connect(layeredAction, &QAction::triggered, [this]() { runLayout(LayoutOptions::Layered); });
+    layoutMenu->addAction(layeredAction);
+
+    QAction *cancelLayoutAction = new QAction("Cancel layout", this);
+    connect(cancelLayoutAction, &QAction::triggered, [this]() { m_layoutRunner->cancel(); });
+    layoutMenu->addAction(cancelLayoutAction);
+
+    QMenu *viewMenu = menuBar()->addMenu("View");
+    viewMenu->addAction(m_propertyDock->toggleViewAction());
+    viewMenu->addAction(m_statsDock->toggleViewAction());
 }
 
 void MainWindow::newFile()
 {
-    m_scene->clear();
+    m_layoutRunner->cancel();
+    m_scene->loadModel(PetriNetModel());
+    m_currentFile.clear();
+    m_autoSaver->compact();
     statusBar()->showMessage("New file created", 2000);
 }
 
@@ -116,27 +290,54 @@ void MainWindow::openFile()
     QString fileName = QFileDialog::getOpenFileName(this, "Open Petri Net", "", "Petri Net Files (*.pn)");
     if (fileName.isEmpty()) return;
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::ReadOnly)) {
-        statusBar()->showMessage("Could not open file", 2000);
+    PetriNetModel model;
+    QString error;
+    if (!PetriNetModel::loadFromFile(fileName, &model, &error)) {
+        statusBar()->showMessage("Could not open file: " + error, 2000);
         return;
     }
 
-    QByteArray data = file.readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (doc.isNull()) {
-        statusBar()->showMessage("Invalid file format", 2000);
+    m_layoutRunner->cancel();
+    m_scene->loadModel(model);
+    m_currentFile = fileName;
+    m_autoSaver->compact();
+    statusBar()->showMessage("File loaded", 2000);
+}
+
+void MainWindow::saveFile()
+{
+    if (m_saveWatcher.isRunning()) {
+        statusBar()->showMessage("Save already in progress", 2000);
         return;
     }
 
-    m_scene->clear();
-    //m_scene->fromJson(doc.object());
-    statusBar()->showMessage("File loaded", 2000);
+    if (m_currentFile.isEmpty()) {
+        QString fileName = QFileDialog::getSaveFileName(this, "Save Petri Net", "", "Petri Net Files (*.pn)");
+        if (fileName.isEmpty()) return;
+        m_currentFile = fileName;
+    }
+
+    // Снимок берётся в потоке GUI, сериализация и запись — в фоне
+    const PetriNetModel model = m_scene->documentModel();
+    const QString fileName = m_currentFile;
+    m_saveWatcher.setFuture(QtConcurrent::run([model, fileName]() {
+        QString error;
+        model.saveToFile(fileName, &error);
+        return error;
+    }));
+    statusBar()->showMessage("Saving...");
 }
 
-void MainWindow::saveFile()
+void MainWindow::onSaveFinished()
 {
-    // Реализация сохранения аналогична открытию, но в обратном порядке
+    const QString error = m_saveWatcher.result();
+    if (!error.isEmpty()) {
+        statusBar()->showMessage("Could not save file: " + error, 2000);
+        return;
+    }
+    // Сохранённое состояние — новая база для журнала автосохранения
+    m_autoSaver->compact();
+    statusBar()->showMessage("File saved", 2000);
 }
 
 void MainWindow::exportToJson()
@@ -154,6 +355,78 @@ void MainWindow::exportToJson()
     // }
 }
 
+void MainWindow::runLayout(LayoutOptions::Algorithm algorithm)
+{
+    // Поток мог завершиться, а его layoutFinished ещё не доставлен
+    if (m_layoutRunner->isRunning() || !m_layoutNodes.isEmpty()) {
+        statusBar()->showMessage("Layout already in progress", 2000);
+        return;
+    }
+
+    const PetriNetModel model = m_scene->toModel();
+    const LayoutGraph graph = LayoutGraph::fromModel(model);
+
+    m_layoutNodes.clear();
+    m_layoutStart.clear();
+    m_layoutNodes.reserve(graph.nodeCount());
+    m_layoutStart.reserve(graph.nodeCount());
+    for (int id : graph.nodeIds) {
+        QGraphicsItem* item = m_scene->nodeById(id);
+        m_layoutNodes.append(dynamic_cast<QObject*>(item));
+        m_layoutStart.append(item ? item->pos() : QPointF());
+    }
+
+    LayoutOptions options;
+    options.algorithm = algorithm;
+    m_layoutRunner->start(graph, m_layoutStart, options);
+    statusBar()->showMessage("Layout running...");
+}
+
+QGraphicsItem *MainWindow::layoutNode(int index) const
+{
+    QGraphicsItem* item = dynamic_cast<QGraphicsItem*>(m_layoutNodes[index].data());
+    // Элемент мог быть удалён со сцены во время раскладки
+    return item && item->scene() == m_scene ? item : nullptr;
+}
+
+void MainWindow::onLayoutFrame(quint64 generation, const QVector<QPointF> &positions)
+{
+    if (generation != m_layoutRunner->generation())
+        return;
+
+    // Промежуточные позиции применяются напрямую, без журнала отмены
+    for (int i = 0; i < positions.size() && i < m_layoutNodes.size(); ++i) {
+        if (QGraphicsItem* item = layoutNode(i))
+            item->setPos(positions[i]);
+    }
+    m_layoutRunner->frameApplied();
+}
+
+void MainWindow::onLayoutFinished(quint64 generation, const QVector<QPointF> &positions, bool cancelled)
+{
+    if (generation != m_layoutRunner->generation())
+        return;
+
+    QVector<QGraphicsItem*> items(m_layoutNodes.size());
+    for (int i = 0; i < items.size(); ++i) {
+        items[i] = layoutNode(i);
+        // Возвращаем исходные позиции; итог (если есть) — одной командой отмены
+        if (items[i])
+            items[i]->setPos(m_layoutStart[i]);
+    }
+
+    if (cancelled || positions.size() != items.size()) {
+        statusBar()->showMessage("Layout cancelled", 2000);
+    } else {
+        m_scene->moveNodes(items, m_layoutStart, positions);
+        m_scene->setSceneRect(m_scene->sceneRect().united(m_scene->itemsBoundingRect().adjusted(-100, -100, 100, 100)));
+        statusBar()->showMessage("Layout finished", 2000);
+    }
+
+    m_layoutNodes.clear();
+    m_layoutStart.clear();
+}
+
 void MainWindow::onPlaceAdded(PetriPlace *place)
 {
     // Обновляем список позиций и свойства
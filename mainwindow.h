@@ -5,6 +5,9 @@
 #include "Scene/Items/petritransition.h"
 #include "Scene/Items/petriarc.h"
 #include "Scene/petrinetscene.h"
+#include "Core/autosaver.h"
+#include "Core/netlayout.h"
+#include "Core/petriprofiler.h"
 
 #include <QMainWindow>
 #include <QToolBar>
@@ -16,6 +19,9 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QTimer>
 
 class MainWindow : public QMainWindow
 {
@@ -28,6 +34,8 @@ public:
     void createToolBar();
     void createDockWidgets();
     void createMenus();
+    void createAutoSaver();
+    void createStatisticsDock();
 
     void newFile();
     void openFile();
@@ -38,10 +46,33 @@ public:
     void onTransitionAdded(PetriTransition *transition);
     void onArcAdded(PetriArc *arc);
 
+    void onSaveFinished();
+
+    void runLayout(LayoutOptions::Algorithm algorithm);
+    void onLayoutFrame(quint64 generation, const QVector<QPointF>& positions);
+    void onLayoutFinished(quint64 generation, const QVector<QPointF>& positions, bool cancelled);
+    QGraphicsItem* layoutNode(int index) const;
+
+    void updateStatistics();
+    void exportTrace();
+
     PetriNetScene* m_scene;
     QGraphicsView* m_view;
 
     QDockWidget* m_propertyDock;
     QTreeWidget* m_propertyEditor;
+
+    QDockWidget* m_statsDock;
+    QTreeWidget* m_statsView;
+    QTimer* m_statsTimer;
+
+    AutoSaver* m_autoSaver;
+    QString m_currentFile;
+    QFutureWatcher<QString> m_saveWatcher;
+
+    LayoutRunner* m_layoutRunner;
+    // Узлы раскладки; QPointer защищает от удаления элемента во время работы
+    QVector<QPointer<QObject>> m_layoutNodes;
+    QVector<QPointF> m_layoutStart;
 };
 #endif // MAINWINDOW_H